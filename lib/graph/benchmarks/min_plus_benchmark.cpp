@@ -0,0 +1,93 @@
+#include "min_plus.h"
+
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "graph.h"
+
+namespace {
+struct Rows {
+  std::vector<double> weights_through;
+  std::vector<graph::EdgeId> prev_edges_through;
+  std::vector<double> weights_from;
+  std::vector<graph::EdgeId> prev_edges_from;
+};
+
+Rows RandomRows(size_t size) {
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> weight(0.0, 100.0);
+  Rows rows;
+  for (size_t i = 0; i < size; ++i) {
+    rows.weights_through.push_back(weight(gen));
+    rows.prev_edges_through.push_back(i);
+    rows.weights_from.push_back(weight(gen) + 50.0);
+    rows.prev_edges_from.push_back(size + i);
+  }
+  return rows;
+}
+
+// Runs the kernel over a fresh copy of the row on every iteration, so about
+// half of the cells get updated like in the early Floyd-Warshall rounds.
+template<typename Kernel>
+void RunKernel(benchmark::State &state, Kernel kernel) {
+  const size_t size = state.range(0);
+  const Rows rows = RandomRows(size);
+  std::vector<double> weights_from;
+  std::vector<graph::EdgeId> prev_edges_from;
+  for (auto _ : state) {
+    state.PauseTiming();
+    weights_from = rows.weights_from;
+    prev_edges_from = rows.prev_edges_from;
+    state.ResumeTiming();
+
+    kernel(40.0, rows.weights_through.data(), rows.prev_edges_through.data(),
+           weights_from.data(), prev_edges_from.data(), size);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+
+bool Supports(graph::min_plus::Kernel kernel, benchmark::State &state) {
+  if (graph::min_plus::DetectKernel() >= kernel) return true;
+  state.SkipWithError("The kernel isn't supported by the CPU");
+  return false;
+}
+
+void BM_RelaxRowScalar(benchmark::State &state) {
+  RunKernel(state, [](auto... args) {
+    graph::min_plus::RelaxRowScalar(args...);
+  });
+}
+
+void BM_RelaxRow(benchmark::State &state) {
+  RunKernel(state, [](auto... args) {
+    graph::min_plus::RelaxRow(args...);
+  });
+}
+
+#if GRAPH_MIN_PLUS_X86
+void BM_RelaxRowSse41(benchmark::State &state) {
+  if (!Supports(graph::min_plus::Kernel::kSse41, state)) return;
+  RunKernel(state, [](auto... args) {
+    graph::min_plus::RelaxRowSse41(args...);
+  });
+}
+
+void BM_RelaxRowAvx2(benchmark::State &state) {
+  if (!Supports(graph::min_plus::Kernel::kAvx2, state)) return;
+  RunKernel(state, [](auto... args) {
+    graph::min_plus::RelaxRowAvx2(args...);
+  });
+}
+#endif
+}
+
+BENCHMARK(BM_RelaxRowScalar)->Arg(64)->Arg(1024)->Arg(16384);
+BENCHMARK(BM_RelaxRow)->Arg(64)->Arg(1024)->Arg(16384);
+#if GRAPH_MIN_PLUS_X86
+BENCHMARK(BM_RelaxRowSse41)->Arg(64)->Arg(1024)->Arg(16384);
+BENCHMARK(BM_RelaxRowAvx2)->Arg(64)->Arg(1024)->Arg(16384);
+#endif
@@ -0,0 +1,192 @@
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "a_star_router.h"
+#include "bidirectional_dijkstra_router.h"
+#include "contraction_hierarchy_router.h"
+#include "dijkstra_router.h"
+#include "graph.h"
+#include "hub_label_router.h"
+#include "overlay_router.h"
+#include "tree_cache_router.h"
+
+namespace {
+// Square grid with two-way streets, the usual shape of a city network.
+graph::DirectedWeightedGraph<double> GridGraph(size_t side) {
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> weight(0.5, 5.0);
+
+  graph::DirectedWeightedGraph<double> graph(side * side);
+  for (graph::VertexId vertex = 0; vertex < side * side; ++vertex) {
+    if (vertex % side + 1 < side) {
+      graph.AddEdge({vertex, vertex + 1, weight(gen)});
+      graph.AddEdge({vertex + 1, vertex, weight(gen)});
+    }
+    if (vertex + side < side * side) {
+      graph.AddEdge({vertex, vertex + side, weight(gen)});
+      graph.AddEdge({vertex + side, vertex, weight(gen)});
+    }
+  }
+  return graph;
+}
+
+// Lower bound of the route weight in GridGraph: every step weighs at least
+// 0.5.
+struct GridHeuristic {
+  double operator()(graph::VertexId from, graph::VertexId to) const {
+    const auto distance = [](size_t lhs, size_t rhs) {
+      return lhs < rhs ? rhs - lhs : lhs - rhs;
+    };
+    return 0.5 * (distance(from % side, to % side) +
+        distance(from / side, to / side));
+  }
+
+  size_t side;
+};
+
+template<typename Router>
+void RunQueries(benchmark::State &state,
+                const Router &router,
+                size_t vertex_count) {
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<graph::VertexId> vertex(0, vertex_count - 1);
+  std::vector<graph::EdgeId> edges;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        router.BuildRoute(vertex(gen), vertex(gen), edges));
+  }
+}
+
+// Also reports the average number of vertices settled per query.
+template<typename Router>
+void RunCountedQueries(benchmark::State &state,
+                       const Router &router,
+                       size_t vertex_count) {
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<graph::VertexId> vertex(0, vertex_count - 1);
+  std::vector<graph::EdgeId> edges;
+  size_t settled_total = 0;
+  for (auto _ : state) {
+    size_t settled_count;
+    benchmark::DoNotOptimize(router.BuildRoute(vertex(gen), vertex(gen), edges,
+                                               &settled_count));
+    settled_total += settled_count;
+  }
+  state.counters["settled"] = benchmark::Counter(
+      settled_total, benchmark::Counter::kAvgIterations);
+}
+
+void BM_DijkstraBuildRoute(benchmark::State &state) {
+  auto graph = GridGraph(state.range(0));
+  graph::DijkstraRouter<double> router(graph);
+  RunCountedQueries(state, router, graph.GetVertexCount());
+}
+
+void BM_BidirectionalDijkstraBuildRoute(benchmark::State &state) {
+  auto graph = GridGraph(state.range(0));
+  graph::BidirectionalDijkstraRouter<double> router(graph);
+  RunCountedQueries(state, router, graph.GetVertexCount());
+}
+
+void BM_AStarBuildRoute(benchmark::State &state) {
+  const size_t side = state.range(0);
+  auto graph = GridGraph(side);
+  graph::AStarRouter<double, GridHeuristic> router(graph, {side});
+  RunCountedQueries(state, router, graph.GetVertexCount());
+}
+
+void BM_ContractionHierarchyInit(benchmark::State &state) {
+  auto graph = GridGraph(state.range(0));
+  for (auto _ : state) {
+    graph::ContractionHierarchyRouter<double> router(graph);
+    state.counters["shortcuts"] = router.GetShortcutCount();
+  }
+}
+
+void BM_ContractionHierarchyBuildRoute(benchmark::State &state) {
+  auto graph = GridGraph(state.range(0));
+  graph::ContractionHierarchyRouter<double> router(graph);
+  RunQueries(state, router, graph.GetVertexCount());
+}
+
+void BM_OverlayInit(benchmark::State &state) {
+  auto graph = GridGraph(state.range(0));
+  for (auto _ : state) {
+    graph::OverlayRouter<double> router(graph);
+    state.counters["cells"] = router.GetCellCount(0);
+    state.counters["boundary"] = router.GetBoundaryVertexCount(0);
+  }
+}
+
+void BM_OverlayCustomize(benchmark::State &state) {
+  auto graph = GridGraph(state.range(0));
+  graph::OverlayRouter<double> router(graph);
+  for (auto _ : state) {
+    router.Customize();
+  }
+}
+
+void BM_OverlayBuildRoute(benchmark::State &state) {
+  auto graph = GridGraph(state.range(0));
+  graph::OverlayRouter<double> router(graph);
+  RunCountedQueries(state, router, graph.GetVertexCount());
+}
+
+void BM_HubLabelInit(benchmark::State &state) {
+  auto graph = GridGraph(state.range(0));
+  for (auto _ : state) {
+    graph::HubLabelRouter<double> router(graph);
+    state.counters["label_entries"] = router.GetLabelEntryCount();
+  }
+}
+
+// Sources drawn from 32 hub vertices, as in the query logs, and targets from
+// the whole grid.
+void BM_TreeCacheBuildRoute(benchmark::State &state) {
+  auto graph = GridGraph(state.range(0));
+  graph::TreeCacheRouter<double> router(graph, 64);
+  const size_t vertex_count = graph.GetVertexCount();
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<graph::VertexId> source(0, 31);
+  std::uniform_int_distribution<graph::VertexId> vertex(0, vertex_count - 1);
+  std::vector<graph::EdgeId> edges;
+  for (auto _ : state) {
+    const graph::VertexId from = source(gen) * vertex_count / 32;
+    benchmark::DoNotOptimize(router.BuildRoute(from, vertex(gen), edges));
+  }
+  state.counters["hits"] = router.GetHitCount();
+  state.counters["misses"] = router.GetMissCount();
+}
+
+void BM_HubLabelBuildRoute(benchmark::State &state) {
+  auto graph = GridGraph(state.range(0));
+  graph::HubLabelRouter<double> router(graph);
+  RunQueries(state, router, graph.GetVertexCount());
+}
+}
+
+BENCHMARK(BM_DijkstraBuildRoute)
+    ->RangeMultiplier(2)->Range(32, 256)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_BidirectionalDijkstraBuildRoute)
+    ->RangeMultiplier(2)->Range(32, 128)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_AStarBuildRoute)
+    ->RangeMultiplier(2)->Range(32, 128)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ContractionHierarchyInit)
+    ->RangeMultiplier(2)->Range(32, 128)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ContractionHierarchyBuildRoute)
+    ->RangeMultiplier(2)->Range(32, 128)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_HubLabelInit)
+    ->RangeMultiplier(2)->Range(32, 64)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_HubLabelBuildRoute)
+    ->RangeMultiplier(2)->Range(32, 64)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_TreeCacheBuildRoute)
+    ->RangeMultiplier(2)->Range(32, 128)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_OverlayInit)
+    ->RangeMultiplier(2)->Range(32, 256)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_OverlayCustomize)
+    ->RangeMultiplier(2)->Range(32, 256)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_OverlayBuildRoute)
+    ->RangeMultiplier(2)->Range(32, 256)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,178 @@
+#include "router.h"
+
+#include <cstddef>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "graph.h"
+
+namespace {
+// Sparse graph with a handful of outgoing edges per vertex, like the
+// arrive/depart graph built by RouteManager.
+graph::DirectedWeightedGraph<double> RandomGraph(size_t vertex_count) {
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<graph::VertexId> vertex(0, vertex_count - 1);
+  std::uniform_real_distribution<double> weight(0.1, 20.0);
+
+  graph::DirectedWeightedGraph<double> graph(vertex_count);
+  for (size_t i = 0; i < vertex_count * 6; ++i) {
+    graph.AddEdge({vertex(gen), vertex(gen), weight(gen)});
+  }
+  return graph;
+}
+
+// RandomGraph split into clusters of 256 vertices without edges between
+// them, like an import of several separate suburbs.
+graph::DirectedWeightedGraph<double> ClusteredGraph(size_t vertex_count) {
+  const size_t cluster_size = 256;
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<graph::VertexId> vertex(0, cluster_size - 1);
+  std::uniform_real_distribution<double> weight(0.1, 20.0);
+
+  graph::DirectedWeightedGraph<double> graph(vertex_count);
+  for (size_t first = 0; first < vertex_count; first += cluster_size) {
+    for (size_t i = 0; i < cluster_size * 6; ++i) {
+      graph.AddEdge({first + vertex(gen), first + vertex(gen), weight(gen)});
+    }
+  }
+  return graph;
+}
+
+// The all-pairs precompute over a vector<vector<optional<...>>> table, as
+// Router did before switching to flat matrices. Kept as the baseline.
+std::vector<std::vector<std::optional<std::pair<double, graph::EdgeId>>>>
+NestedFloydWarshall(const graph::DirectedWeightedGraph<double> &graph) {
+  const size_t vertex_count = graph.GetVertexCount();
+  std::vector<std::vector<std::optional<std::pair<double, graph::EdgeId>>>>
+      routes(vertex_count, std::vector<std::optional<
+          std::pair<double, graph::EdgeId>>>(vertex_count));
+  for (graph::VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+    routes[vertex][vertex] = {0, 0};
+    for (auto edge_id : graph.GetIncidentEdges(vertex)) {
+      auto &edge = graph.GetEdge(edge_id);
+      auto &route = routes[vertex][edge.to];
+      if (!route || route->first > edge.weight) route = {edge.weight, edge_id};
+    }
+  }
+  for (graph::VertexId through = 0; through < vertex_count; ++through) {
+    for (graph::VertexId from = 0; from < vertex_count; ++from) {
+      auto &route_from = routes[from][through];
+      if (!route_from) continue;
+      for (graph::VertexId to = 0; to < vertex_count; ++to) {
+        auto &route_to = routes[through][to];
+        if (!route_to) continue;
+        auto &route = routes[from][to];
+        const double weight = route_from->first + route_to->first;
+        if (!route || weight < route->first) {
+          route = {weight, route_to->second};
+        }
+      }
+    }
+  }
+  return routes;
+}
+
+void BM_NestedFloydWarshall(benchmark::State &state) {
+  auto graph = RandomGraph(state.range(0));
+  for (auto _ : state) {
+    auto routes = NestedFloydWarshall(graph);
+    benchmark::DoNotOptimize(routes.data());
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_RouterInit(benchmark::State &state) {
+  auto graph = RandomGraph(state.range(0));
+  for (auto _ : state) {
+    graph::Router<double> router(graph);
+    benchmark::DoNotOptimize(&router);
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_CompactRouterInit(benchmark::State &state) {
+  auto graph = RandomGraph(state.range(0));
+  for (auto _ : state) {
+    graph::CompactRouter<double> router(graph);
+    benchmark::DoNotOptimize(&router);
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_FixedPointRouterInit(benchmark::State &state) {
+  auto graph = RandomGraph(state.range(0));
+  for (auto _ : state) {
+    graph::FixedPointRouter<double> router(graph);
+    benchmark::DoNotOptimize(&router);
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_RouterInitClustered(benchmark::State &state) {
+  auto graph = ClusteredGraph(state.range(0));
+  for (auto _ : state) {
+    graph::Router<double> router(graph);
+    state.counters["cells"] = router.GetCellCount();
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_RouterInitThreads(benchmark::State &state) {
+  auto graph = RandomGraph(1024);
+  for (auto _ : state) {
+    graph::Router<double> router(graph, state.range(0));
+    benchmark::DoNotOptimize(&router);
+  }
+}
+
+// One inserted edge per iteration, against BM_RouterInit for the rebuild.
+void BM_RouterUpdateEdge(benchmark::State &state) {
+  auto graph = RandomGraph(state.range(0));
+  graph::Router<double> router(graph);
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<graph::VertexId> vertex(0, state.range(0) - 1);
+  std::uniform_real_distribution<double> weight(0.1, 20.0);
+  for (auto _ : state) {
+    router.UpdateEdge(graph.AddEdge({vertex(gen), vertex(gen), weight(gen)}));
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+void BM_RouterBuildRoute(benchmark::State &state) {
+  auto graph = RandomGraph(state.range(0));
+  graph::Router<double> router(graph);
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<graph::VertexId> vertex(0, state.range(0) - 1);
+  std::vector<graph::EdgeId> edges;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        router.BuildRoute(vertex(gen), vertex(gen), edges));
+  }
+}
+}
+
+BENCHMARK(BM_NestedFloydWarshall)
+    ->RangeMultiplier(2)->Range(256, 2048)
+    ->Unit(benchmark::kMillisecond)->Complexity(benchmark::oNCubed);
+BENCHMARK(BM_RouterInit)
+    ->RangeMultiplier(2)->Range(256, 2048)
+    ->Unit(benchmark::kMillisecond)->Complexity(benchmark::oNCubed);
+BENCHMARK(BM_CompactRouterInit)
+    ->RangeMultiplier(2)->Range(256, 2048)
+    ->Unit(benchmark::kMillisecond)->Complexity(benchmark::oNCubed);
+BENCHMARK(BM_FixedPointRouterInit)
+    ->RangeMultiplier(2)->Range(256, 2048)
+    ->Unit(benchmark::kMillisecond)->Complexity(benchmark::oNCubed);
+BENCHMARK(BM_RouterInitClustered)
+    ->RangeMultiplier(2)->Range(256, 2048)
+    ->Unit(benchmark::kMillisecond)->Complexity(benchmark::oN);
+BENCHMARK(BM_RouterUpdateEdge)
+    ->RangeMultiplier(2)->Range(256, 2048)
+    ->Unit(benchmark::kMicrosecond)->Complexity(benchmark::oNSquared);
+BENCHMARK(BM_RouterInitThreads)
+    ->RangeMultiplier(2)->Range(1, 32)
+    ->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_RouterBuildRoute)->Arg(1024);
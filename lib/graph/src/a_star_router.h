@@ -0,0 +1,166 @@
+#ifndef GRAPH_A_STAR_ROUTER_H_
+#define GRAPH_A_STAR_ROUTER_H_
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.h"
+#include "graph.h"
+
+namespace graph {
+// Heuristic that knows nothing of the graph, see DijkstraRouter.
+template<typename Weight>
+struct ZeroHeuristic {
+  Weight operator()(VertexId, VertexId) const { return Weight{}; }
+};
+
+// AStarRouter answers every query with a separate binary-heap search that
+// settles the vertices in the order of the route weight plus
+// `heuristic(vertex, to)`, a lower bound of the weight from vertex to the
+// target, so it explores less of the graph away from the target. The
+// heuristic must be consistent: for every edge, the weight is at least the
+// difference of the heuristic at its ends, and it is 0 at the target. The
+// routes are then shortest. With a zero heuristic it is DijkstraRouter. The
+// search runs over a CsrGraph copy of the graph.
+template<typename Weight, typename Heuristic>
+class AStarRouter {
+ private:
+  using Graph = DirectedWeightedGraph<Weight>;
+
+ public:
+  // Time: O(V+E), Mem: O(V+E).
+  explicit AStarRouter(const Graph &graph, Heuristic heuristic = {});
+
+  // Returns the weight of the route and replaces the content of `edges` with
+  // its edges. Counts the settled vertices into `settled_count` if it isn't
+  // null. Doesn't modify the router, so it may be called concurrently.
+  // Time: O((V+E)logV) and O(V) calls of heuristic, Mem: O(V+E) once per
+  // thread, V - number of vertices, E - number of edges.
+  std::optional<Weight> BuildRoute(VertexId from,
+                                   VertexId to,
+                                   std::vector<EdgeId> &edges,
+                                   size_t *settled_count = nullptr) const;
+
+  // The graph the router searches, e.g. to grow shortest path trees on.
+  const CsrGraph<Weight> &GetGraph() const;
+
+ private:
+  // The zero heuristic needs neither calls nor storage.
+  static constexpr bool kHasHeuristic =
+      !std::is_same_v<Heuristic, ZeroHeuristic<Weight>>;
+  // Route weight with the heuristic, vertex.
+  using QueueItem = std::pair<Weight, VertexId>;
+
+  // Per-thread buffers of a search. Only the vertices in `visited` differ
+  // from the initial state, so resetting them keeps a query O(visited).
+  struct SearchState {
+    std::vector<std::optional<Weight>> weights;
+    // The heuristic of a visited vertex, computed once per query. Empty
+    // without kHasHeuristic.
+    std::vector<Weight> heuristics;
+    std::vector<EdgeId> prev_edges;
+    std::vector<VertexId> visited;
+    std::vector<QueueItem> queue;
+  };
+
+  static SearchState &GetSearchState(size_t vertex_count);
+
+  const CsrGraph<Weight> graph_;
+  const Heuristic heuristic_;
+};
+
+template<typename Weight, typename Heuristic>
+AStarRouter<Weight, Heuristic>::AStarRouter(const Graph &graph,
+                                            Heuristic heuristic)
+    : graph_(graph), heuristic_(std::move(heuristic)) {}
+
+template<typename Weight, typename Heuristic>
+typename AStarRouter<Weight, Heuristic>::SearchState &
+AStarRouter<Weight, Heuristic>::GetSearchState(size_t vertex_count) {
+  thread_local SearchState state;
+  if (state.weights.size() < vertex_count) {
+    state.weights.resize(vertex_count);
+    if constexpr (kHasHeuristic) state.heuristics.resize(vertex_count);
+    state.prev_edges.resize(vertex_count);
+  }
+  return state;
+}
+
+template<typename Weight, typename Heuristic>
+std::optional<Weight> AStarRouter<Weight, Heuristic>::BuildRoute(
+    VertexId from,
+    VertexId to,
+    std::vector<EdgeId> &edges,
+    size_t *settled_count) const {
+  edges.clear();
+  auto &[weights, heuristics, prev_edges, visited, queue] =
+      GetSearchState(graph_.GetVertexCount());
+  const auto priority = [&](VertexId vertex, Weight weight) {
+    if constexpr (kHasHeuristic) {
+      return weight + heuristics[vertex];
+    } else {
+      return weight;
+    }
+  };
+  const auto update = [&](VertexId vertex, Weight weight) {
+    if (!weights[vertex]) {
+      visited.push_back(vertex);
+      if constexpr (kHasHeuristic) heuristics[vertex] = heuristic_(vertex, to);
+    }
+    weights[vertex] = weight;
+    queue.push_back({priority(vertex, weight), vertex});
+    std::push_heap(std::begin(queue), std::end(queue), std::greater<>());
+  };
+
+  size_t settled = 0;
+  update(from, 0);
+  while (!queue.empty()) {
+    std::pop_heap(std::begin(queue), std::end(queue), std::greater<>());
+    const auto [queued_priority, vertex] = queue.back();
+    queue.pop_back();
+    // Skip stale entries left after the vertex was relaxed again.
+    const Weight weight = *weights[vertex];
+    if (priority(vertex, weight) < queued_priority) continue;
+    ++settled;
+    if (vertex == to) break;
+
+    for (const auto &arc : graph_.GetOutgoingArcs(vertex)) {
+      const Weight candidate_weight = weight + arc.weight;
+      const auto &weight_to = weights[arc.to];
+      if (!weight_to || candidate_weight < *weight_to) {
+        prev_edges[arc.to] = arc.edge_id;
+        update(arc.to, candidate_weight);
+      }
+    }
+  }
+
+  const std::optional<Weight> weight = weights[to];
+  if (weight) {
+    for (VertexId vertex = to; vertex != from;
+         vertex = graph_.GetEdge(edges.back()).from) {
+      edges.push_back(prev_edges[vertex]);
+    }
+    std::reverse(std::begin(edges), std::end(edges));
+  }
+
+  for (const VertexId vertex : visited) {
+    weights[vertex].reset();
+  }
+  visited.clear();
+  queue.clear();
+  if (settled_count) *settled_count = settled;
+  return weight;
+}
+
+template<typename Weight, typename Heuristic>
+const CsrGraph<Weight> &AStarRouter<Weight, Heuristic>::GetGraph() const {
+  return graph_;
+}
+}
+
+#endif // GRAPH_A_STAR_ROUTER_H_
@@ -0,0 +1,164 @@
+#ifndef GRAPH_BIDIRECTIONAL_DIJKSTRA_ROUTER_H_
+#define GRAPH_BIDIRECTIONAL_DIJKSTRA_ROUTER_H_
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.h"
+#include "graph.h"
+
+namespace graph {
+// BidirectionalDijkstraRouter runs a forward search from the source over the
+// outgoing arcs and a backward search from the target over the incoming arcs,
+// stopping once the two frontiers together can't beat the best meeting found.
+// Each search covers about half the radius of a one-sided Dijkstra, so it
+// settles fewer vertices on long queries. Weights must be non-negative.
+template<typename Weight>
+class BidirectionalDijkstraRouter {
+ private:
+  using Graph = DirectedWeightedGraph<Weight>;
+
+ public:
+  // Time: O(V+E), Mem: O(V+E).
+  explicit BidirectionalDijkstraRouter(const Graph &graph);
+
+  // Returns the weight of the route and replaces the content of `edges` with
+  // its edges. Counts the settled vertices into `settled_count` if it isn't
+  // null. Doesn't modify the router, so it may be called concurrently.
+  // Time: O((V+E)logV), Mem: O(V+E) once per thread.
+  std::optional<Weight> BuildRoute(VertexId from,
+                                   VertexId to,
+                                   std::vector<EdgeId> &edges,
+                                   size_t *settled_count = nullptr) const;
+
+  // The graph the router searches, e.g. to grow shortest path trees on.
+  const CsrGraph<Weight> &GetGraph() const;
+
+ private:
+  using QueueItem = std::pair<Weight, VertexId>;
+
+  // Per-thread buffers of the forward (0) and backward (1) searches. Only
+  // the visited vertices differ from the initial state, so resetting them
+  // keeps a query O(visited).
+  struct SearchState {
+    std::vector<std::optional<Weight>> weights[2];
+    std::vector<EdgeId> prev_edges[2];
+    std::vector<VertexId> visited[2];
+    std::vector<QueueItem> queues[2];
+  };
+
+  static SearchState &GetSearchState(size_t vertex_count);
+
+  const CsrGraph<Weight> graph_;
+};
+
+template<typename Weight>
+BidirectionalDijkstraRouter<Weight>::BidirectionalDijkstraRouter(
+    const Graph &graph)
+    : graph_(graph, true) {}
+
+template<typename Weight>
+typename BidirectionalDijkstraRouter<Weight>::SearchState &
+BidirectionalDijkstraRouter<Weight>::GetSearchState(size_t vertex_count) {
+  thread_local SearchState state;
+  for (int side = 0; side < 2; ++side) {
+    if (state.weights[side].size() < vertex_count) {
+      state.weights[side].resize(vertex_count);
+      state.prev_edges[side].resize(vertex_count);
+    }
+  }
+  return state;
+}
+
+template<typename Weight>
+std::optional<Weight> BidirectionalDijkstraRouter<Weight>::BuildRoute(
+    VertexId from,
+    VertexId to,
+    std::vector<EdgeId> &edges,
+    size_t *settled_count) const {
+  edges.clear();
+  auto &[weights, prev_edges, visited, queues] =
+      GetSearchState(graph_.GetVertexCount());
+
+  std::optional<Weight> best_weight;
+  VertexId meeting_vertex = from;
+  // Every improved label is checked against the other side, so best_weight
+  // is the shortest route through a vertex labeled by both searches.
+  const auto update = [&](int side, VertexId vertex, Weight weight) {
+    if (!weights[side][vertex]) visited[side].push_back(vertex);
+    weights[side][vertex] = weight;
+    queues[side].push_back({weight, vertex});
+    std::push_heap(queues[side].begin(), queues[side].end(), std::greater<>());
+    if (const auto &other_weight = weights[side ^ 1][vertex]) {
+      if (!best_weight || weight + *other_weight < *best_weight) {
+        best_weight = weight + *other_weight;
+        meeting_vertex = vertex;
+      }
+    }
+  };
+
+  size_t settled = 0;
+  update(0, from, 0);
+  update(1, to, 0);
+  while (!queues[0].empty() && !queues[1].empty()) {
+    // A shorter route would have to be longer than both frontiers together.
+    if (best_weight &&
+        !(queues[0].front().first + queues[1].front().first < *best_weight))
+      break;
+    // Advancing the search with the nearer frontier keeps their radii equal.
+    const int side =
+        queues[1].front().first < queues[0].front().first ? 1 : 0;
+    auto &queue = queues[side];
+    std::pop_heap(queue.begin(), queue.end(), std::greater<>());
+    const auto [weight, vertex] = queue.back();
+    queue.pop_back();
+    // Skip stale entries left after the vertex was relaxed again.
+    if (*weights[side][vertex] < weight) continue;
+    ++settled;
+
+    const auto arcs = side == 0 ? graph_.GetOutgoingArcs(vertex)
+                                : graph_.GetIncomingArcs(vertex);
+    for (const auto &arc : arcs) {
+      const Weight candidate_weight = weight + arc.weight;
+      const auto &weight_to = weights[side][arc.to];
+      if (!weight_to || candidate_weight < *weight_to) {
+        prev_edges[side][arc.to] = arc.edge_id;
+        update(side, arc.to, candidate_weight);
+      }
+    }
+  }
+
+  if (best_weight) {
+    for (VertexId vertex = meeting_vertex; vertex != from;
+         vertex = graph_.GetEdge(edges.back()).from) {
+      edges.push_back(prev_edges[0][vertex]);
+    }
+    std::reverse(std::begin(edges), std::end(edges));
+    for (VertexId vertex = meeting_vertex; vertex != to;
+         vertex = graph_.GetEdge(edges.back()).to) {
+      edges.push_back(prev_edges[1][vertex]);
+    }
+  }
+
+  for (int side = 0; side < 2; ++side) {
+    for (const VertexId vertex : visited[side]) {
+      weights[side][vertex].reset();
+    }
+    visited[side].clear();
+    queues[side].clear();
+  }
+  if (settled_count) *settled_count = settled;
+  return best_weight;
+}
+
+template<typename Weight>
+const CsrGraph<Weight> &BidirectionalDijkstraRouter<Weight>::GetGraph() const {
+  return graph_;
+}
+}
+
+#endif // GRAPH_BIDIRECTIONAL_DIJKSTRA_ROUTER_H_
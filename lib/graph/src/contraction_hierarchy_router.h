@@ -0,0 +1,411 @@
+#ifndef GRAPH_CONTRACTION_HIERARCHY_ROUTER_H_
+#define GRAPH_CONTRACTION_HIERARCHY_ROUTER_H_
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "graph.h"
+
+namespace graph {
+// ContractionHierarchyRouter contracts the vertices one by one in the order of
+// their importance, adding shortcut edges that keep the distances between the
+// remaining vertices. A query then runs two Dijkstra searches that only go up
+// the order: forward from the source and backward from the target. Shortcuts
+// are unpacked into the edges of the graph. Weights must be non-negative.
+template<typename Weight>
+class ContractionHierarchyRouter {
+ private:
+  using Graph = DirectedWeightedGraph<Weight>;
+
+ public:
+  // Time: O(V*D^2*W), Mem: O(V+E+S), D - degree of a vertex when it is
+  // contracted, W - cost of a witness search, bounded by kWitnessSettleLimit,
+  // S - number of shortcuts.
+  explicit ContractionHierarchyRouter(const Graph &graph);
+
+  // Returns the weight of the route and replaces the content of `edges` with
+  // its edges. Doesn't modify the router, so it may be called concurrently.
+  // Time: O((V'+E')logV'+R), Mem: O(V) once per thread, V' and E' - vertices
+  // and edges above `from` and `to` in the hierarchy, R - size of the route.
+  std::optional<Weight> BuildRoute(VertexId from,
+                                   VertexId to,
+                                   std::vector<EdgeId> &edges) const;
+
+  size_t GetShortcutCount() const;
+
+ private:
+  static constexpr EdgeId kNoEdge = std::numeric_limits<EdgeId>::max();
+  // Vertices a witness search settles before giving up. A failed search only
+  // adds a redundant shortcut.
+  static constexpr size_t kWitnessSettleLimit = 500;
+
+  // Edges of the graph keep their ids, shortcuts follow them and refer to the
+  // two edges they replace.
+  struct HierarchyEdge {
+    VertexId from;
+    VertexId to;
+    Weight weight;
+    EdgeId first = kNoEdge;
+    EdgeId second = kNoEdge;
+  };
+
+  using IncidenceList = std::vector<EdgeId>;
+  using QueueItem = std::pair<Weight, VertexId>;
+
+  // Per-thread buffers of the forward (0) and backward (1) searches of
+  // BuildRoute. Only the visited vertices differ from the initial state, so
+  // a query doesn't pay for the whole graph.
+  struct SearchState {
+    std::vector<std::optional<Weight>> weights[2];
+    std::vector<EdgeId> prev_edges[2];
+    std::vector<VertexId> visited[2];
+    std::vector<QueueItem> queues[2];
+    // Route over the hierarchy edges and the shortcuts left to unpack.
+    std::vector<EdgeId> hierarchy_edges;
+    std::vector<EdgeId> unpack_stack;
+  };
+
+  static SearchState &GetSearchState(size_t vertex_count);
+
+  // Returns the lightest edges to or from distinct vertices that aren't
+  // contracted yet, skipping `vertex` itself.
+  std::vector<EdgeId> LightestEdges(const IncidenceList &edge_ids,
+                                    VertexId vertex,
+                                    bool incoming) const;
+  // Shortcuts needed to contract `vertex` without changing the distances.
+  std::vector<HierarchyEdge> FindShortcuts(VertexId vertex);
+  // Limited Dijkstra search from `from` that avoids `skipped` and stops at
+  // `max_weight`. Leaves the distances in witness_weights_.
+  void RunWitnessSearch(VertexId from, VertexId skipped, Weight max_weight);
+  int ComputePriority(VertexId vertex);
+  void ContractVertex(VertexId vertex);
+  void Contract();
+
+  void UnpackEdge(EdgeId edge_id,
+                  std::vector<EdgeId> &stack,
+                  std::vector<EdgeId> &edges) const;
+
+  const Graph &graph_;
+  std::vector<HierarchyEdge> edges_;
+  // rank_[vertex] - position of the vertex in the contraction order.
+  std::vector<size_t> rank_;
+  // Edges to higher-ranked vertices, by their lower end: forward search
+  // follows up_edges_[from], backward search follows down_edges_[to] to
+  // edge.from.
+  std::vector<IncidenceList> up_edges_;
+  std::vector<IncidenceList> down_edges_;
+
+  // State of the contraction, released when it is finished.
+  std::vector<IncidenceList> out_edges_;
+  std::vector<IncidenceList> in_edges_;
+  std::vector<bool> contracted_;
+  std::vector<int> contracted_neighbors_;
+  std::vector<std::optional<Weight>> witness_weights_;
+  std::vector<VertexId> witness_visited_;
+};
+
+template<typename Weight>
+ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(
+    const Graph &graph)
+    : graph_(graph),
+      rank_(graph.GetVertexCount()),
+      up_edges_(graph.GetVertexCount()),
+      down_edges_(graph.GetVertexCount()) {
+  const size_t vertex_count = graph.GetVertexCount();
+  out_edges_.resize(vertex_count);
+  in_edges_.resize(vertex_count);
+  contracted_.resize(vertex_count);
+  contracted_neighbors_.resize(vertex_count);
+  witness_weights_.resize(vertex_count);
+
+  for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+    auto &edge = graph.GetEdge(edge_id);
+    edges_.push_back({edge.from, edge.to, edge.weight});
+    // Loops never shorten a route.
+    if (edge.from == edge.to) continue;
+    out_edges_[edge.from].push_back(edge_id);
+    in_edges_[edge.to].push_back(edge_id);
+  }
+  Contract();
+
+  for (EdgeId edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+    auto &edge = edges_[edge_id];
+    if (edge.from == edge.to) continue;
+    if (rank_[edge.from] < rank_[edge.to]) {
+      up_edges_[edge.from].push_back(edge_id);
+    } else {
+      down_edges_[edge.to].push_back(edge_id);
+    }
+  }
+
+  out_edges_ = {};
+  in_edges_ = {};
+  contracted_ = {};
+  contracted_neighbors_ = {};
+  witness_weights_ = {};
+  witness_visited_ = {};
+}
+
+template<typename Weight>
+std::vector<EdgeId> ContractionHierarchyRouter<Weight>::LightestEdges(
+    const IncidenceList &edge_ids,
+    VertexId vertex,
+    bool incoming) const {
+  std::vector<EdgeId> lightest;
+  for (const EdgeId edge_id : edge_ids) {
+    auto &edge = edges_[edge_id];
+    const VertexId other = incoming ? edge.from : edge.to;
+    if (other != vertex && !contracted_[other]) lightest.push_back(edge_id);
+  }
+  auto other_vertex = [&](EdgeId edge_id) {
+    return incoming ? edges_[edge_id].from : edges_[edge_id].to;
+  };
+  std::sort(lightest.begin(), lightest.end(), [&](EdgeId lhs, EdgeId rhs) {
+    return std::pair(other_vertex(lhs), edges_[lhs].weight) <
+        std::pair(other_vertex(rhs), edges_[rhs].weight);
+  });
+  lightest.erase(
+      std::unique(lightest.begin(), lightest.end(),
+                  [&](EdgeId lhs, EdgeId rhs) {
+                    return other_vertex(lhs) == other_vertex(rhs);
+                  }),
+      lightest.end());
+  return lightest;
+}
+
+template<typename Weight>
+void ContractionHierarchyRouter<Weight>::RunWitnessSearch(
+    VertexId from,
+    VertexId skipped,
+    Weight max_weight) {
+  for (const VertexId vertex : witness_visited_) {
+    witness_weights_[vertex].reset();
+  }
+  witness_visited_.clear();
+
+  std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<>> queue;
+  witness_weights_[from] = 0;
+  witness_visited_.push_back(from);
+  queue.push({0, from});
+  size_t settled_count = 0;
+  while (!queue.empty() && settled_count < kWitnessSettleLimit) {
+    const auto [weight, vertex] = queue.top();
+    queue.pop();
+    if (*witness_weights_[vertex] < weight) continue;
+    if (max_weight < weight) break;
+    ++settled_count;
+
+    for (const EdgeId edge_id : out_edges_[vertex]) {
+      auto &edge = edges_[edge_id];
+      if (edge.to == skipped || contracted_[edge.to]) continue;
+      const Weight candidate_weight = weight + edge.weight;
+      auto &weight_to = witness_weights_[edge.to];
+      if (!weight_to) witness_visited_.push_back(edge.to);
+      if (!weight_to || candidate_weight < *weight_to) {
+        weight_to = candidate_weight;
+        queue.push({candidate_weight, edge.to});
+      }
+    }
+  }
+}
+
+template<typename Weight>
+std::vector<typename ContractionHierarchyRouter<Weight>::HierarchyEdge>
+ContractionHierarchyRouter<Weight>::FindShortcuts(VertexId vertex) {
+  std::vector<HierarchyEdge> shortcuts;
+  const auto in_edges = LightestEdges(in_edges_[vertex], vertex, true);
+  const auto out_edges = LightestEdges(out_edges_[vertex], vertex, false);
+  if (in_edges.empty() || out_edges.empty()) return shortcuts;
+
+  Weight max_out_weight = edges_[out_edges.front()].weight;
+  for (const EdgeId edge_id : out_edges) {
+    max_out_weight = std::max(max_out_weight, edges_[edge_id].weight);
+  }
+  for (const EdgeId in_edge_id : in_edges) {
+    auto &in_edge = edges_[in_edge_id];
+    RunWitnessSearch(in_edge.from, vertex, in_edge.weight + max_out_weight);
+    for (const EdgeId out_edge_id : out_edges) {
+      auto &out_edge = edges_[out_edge_id];
+      if (out_edge.to == in_edge.from) continue;
+      const Weight weight = in_edge.weight + out_edge.weight;
+      auto &witness_weight = witness_weights_[out_edge.to];
+      if (witness_weight && !(weight < *witness_weight)) continue;
+      shortcuts.push_back(
+          {in_edge.from, out_edge.to, weight, in_edge_id, out_edge_id});
+    }
+  }
+  return shortcuts;
+}
+
+// Edge difference plus the number of contracted neighbors, which spreads the
+// contraction evenly over the graph.
+template<typename Weight>
+int ContractionHierarchyRouter<Weight>::ComputePriority(VertexId vertex) {
+  const int shortcut_count = FindShortcuts(vertex).size();
+  const int removed_count =
+      LightestEdges(in_edges_[vertex], vertex, true).size() +
+          LightestEdges(out_edges_[vertex], vertex, false).size();
+  return shortcut_count - removed_count + contracted_neighbors_[vertex];
+}
+
+template<typename Weight>
+void ContractionHierarchyRouter<Weight>::ContractVertex(VertexId vertex) {
+  for (auto &shortcut : FindShortcuts(vertex)) {
+    const EdgeId edge_id = edges_.size();
+    edges_.push_back(shortcut);
+    out_edges_[shortcut.from].push_back(edge_id);
+    in_edges_[shortcut.to].push_back(edge_id);
+  }
+  contracted_[vertex] = true;
+  for (const EdgeId edge_id : out_edges_[vertex]) {
+    ++contracted_neighbors_[edges_[edge_id].to];
+  }
+  for (const EdgeId edge_id : in_edges_[vertex]) {
+    ++contracted_neighbors_[edges_[edge_id].from];
+  }
+}
+
+template<typename Weight>
+void ContractionHierarchyRouter<Weight>::Contract() {
+  using QueueItem = std::pair<int, VertexId>;
+  std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<>> queue;
+  for (VertexId vertex = 0; vertex < graph_.GetVertexCount(); ++vertex) {
+    queue.push({ComputePriority(vertex), vertex});
+  }
+
+  size_t rank = 0;
+  while (!queue.empty()) {
+    const VertexId vertex = queue.top().second;
+    queue.pop();
+    // Priorities change as the neighbors are contracted, so they are checked
+    // lazily when a vertex reaches the top.
+    const int priority = ComputePriority(vertex);
+    if (!queue.empty() && priority > queue.top().first) {
+      queue.push({priority, vertex});
+      continue;
+    }
+    ContractVertex(vertex);
+    rank_[vertex] = rank++;
+  }
+}
+
+template<typename Weight>
+typename ContractionHierarchyRouter<Weight>::SearchState &
+ContractionHierarchyRouter<Weight>::GetSearchState(size_t vertex_count) {
+  thread_local SearchState state;
+  for (int side = 0; side < 2; ++side) {
+    if (state.weights[side].size() < vertex_count) {
+      state.weights[side].resize(vertex_count);
+      state.prev_edges[side].resize(vertex_count, kNoEdge);
+    }
+  }
+  return state;
+}
+
+template<typename Weight>
+std::optional<Weight> ContractionHierarchyRouter<Weight>::BuildRoute(
+    VertexId from,
+    VertexId to,
+    std::vector<EdgeId> &edges) const {
+  edges.clear();
+  auto &[weights, prev_edges, visited, queues, hierarchy_edges, unpack_stack] =
+      GetSearchState(graph_.GetVertexCount());
+  const auto update = [&](int side, VertexId vertex, Weight weight) {
+    if (!weights[side][vertex]) visited[side].push_back(vertex);
+    weights[side][vertex] = weight;
+    queues[side].push_back({weight, vertex});
+    std::push_heap(queues[side].begin(), queues[side].end(), std::greater<>());
+  };
+  update(0, from, 0);
+  update(1, to, 0);
+
+  std::optional<Weight> best_weight;
+  VertexId meeting_vertex = from;
+  for (int side = 0; !queues[0].empty() || !queues[1].empty(); side ^= 1) {
+    auto &queue = queues[side];
+    if (queue.empty()) continue;
+    std::pop_heap(queue.begin(), queue.end(), std::greater<>());
+    const auto [weight, vertex] = queue.back();
+    queue.pop_back();
+    if (*weights[side][vertex] < weight) continue;
+    // Anything settled later in this direction is at least as long.
+    if (best_weight && !(weight < *best_weight)) {
+      queue.clear();
+      continue;
+    }
+    if (auto &other_weight = weights[side ^ 1][vertex]) {
+      if (!best_weight || weight + *other_weight < *best_weight) {
+        best_weight = weight + *other_weight;
+        meeting_vertex = vertex;
+      }
+    }
+
+    for (const EdgeId edge_id : (side == 0 ? up_edges_ : down_edges_)[vertex]) {
+      auto &edge = edges_[edge_id];
+      const VertexId next = side == 0 ? edge.to : edge.from;
+      const Weight candidate_weight = weight + edge.weight;
+      const auto &weight_next = weights[side][next];
+      if (!weight_next || candidate_weight < *weight_next) {
+        prev_edges[side][next] = edge_id;
+        update(side, next, candidate_weight);
+      }
+    }
+  }
+
+  if (best_weight) {
+    hierarchy_edges.clear();
+    for (VertexId vertex = meeting_vertex; vertex != from;
+         vertex = edges_[hierarchy_edges.back()].from) {
+      hierarchy_edges.push_back(prev_edges[0][vertex]);
+    }
+    std::reverse(std::begin(hierarchy_edges), std::end(hierarchy_edges));
+    for (VertexId vertex = meeting_vertex; vertex != to;
+         vertex = edges_[hierarchy_edges.back()].to) {
+      hierarchy_edges.push_back(prev_edges[1][vertex]);
+    }
+    for (const EdgeId edge_id : hierarchy_edges) {
+      UnpackEdge(edge_id, unpack_stack, edges);
+    }
+  }
+
+  for (int side = 0; side < 2; ++side) {
+    for (const VertexId vertex : visited[side]) {
+      weights[side][vertex].reset();
+    }
+    visited[side].clear();
+    queues[side].clear();
+  }
+  return best_weight;
+}
+
+template<typename Weight>
+void ContractionHierarchyRouter<Weight>::UnpackEdge(
+    EdgeId edge_id,
+    std::vector<EdgeId> &stack,
+    std::vector<EdgeId> &edges) const {
+  stack = {edge_id};
+  while (!stack.empty()) {
+    const EdgeId top = stack.back();
+    stack.pop_back();
+    if (edges_[top].first == kNoEdge) {
+      edges.push_back(top);
+    } else {
+      stack.push_back(edges_[top].second);
+      stack.push_back(edges_[top].first);
+    }
+  }
+}
+
+template<typename Weight>
+size_t ContractionHierarchyRouter<Weight>::GetShortcutCount() const {
+  return edges_.size() - graph_.GetEdgeCount();
+}
+}
+
+#endif // GRAPH_CONTRACTION_HIERARCHY_ROUTER_H_
@@ -0,0 +1,122 @@
+#ifndef GRAPH_CSR_GRAPH_H_
+#define GRAPH_CSR_GRAPH_H_
+
+#include <cstdlib>
+#include <vector>
+
+#include "graph.h"
+
+namespace graph {
+// CsrGraph is an immutable copy of a DirectedWeightedGraph packed in the
+// compressed sparse row layout: the outgoing arcs of every vertex lie next to
+// each other and carry the target and the weight, so a traversal reads them
+// linearly without looking the edges up. The incoming arcs, packed the same
+// way, are kept only on request.
+template<typename Weight>
+class CsrGraph {
+ public:
+  struct Arc {
+    VertexId to;
+    Weight weight;
+    // Id of the edge in the source graph.
+    EdgeId edge_id;
+  };
+
+ private:
+  using ArcsRange = Range<const Arc *>;
+
+ public:
+  // Keeps the order of the incident edges. Time: O(V+E), Mem: O(V+E).
+  explicit CsrGraph(const DirectedWeightedGraph<Weight> &graph,
+                    bool with_incoming_arcs = false);
+
+  size_t GetVertexCount() const;
+  size_t GetEdgeCount() const;
+  const Edge<Weight> &GetEdge(EdgeId edge_id) const;
+  ArcsRange GetOutgoingArcs(VertexId vertex) const;
+  // Arcs of the reversed graph: `to` is the vertex the edge comes from. Empty
+  // unless the graph was built with_incoming_arcs.
+  ArcsRange GetIncomingArcs(VertexId vertex) const;
+
+ private:
+  // Arcs of `vertex` are arcs[offsets[vertex]..offsets[vertex + 1]).
+  struct Arcs {
+    std::vector<size_t> offsets;
+    std::vector<Arc> arcs;
+
+    ArcsRange Get(VertexId vertex) const;
+  };
+
+  std::vector<Edge<Weight>> edges_;
+  Arcs outgoing_;
+  Arcs incoming_;
+};
+
+template<typename Weight>
+CsrGraph<Weight>::CsrGraph(const DirectedWeightedGraph<Weight> &graph,
+                           bool with_incoming_arcs) {
+  const size_t vertex_count = graph.GetVertexCount();
+  edges_.reserve(graph.GetEdgeCount());
+  for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+    edges_.push_back(graph.GetEdge(edge_id));
+  }
+
+  outgoing_.offsets.resize(vertex_count + 1);
+  outgoing_.arcs.reserve(edges_.size());
+  for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+    outgoing_.offsets[vertex] = outgoing_.arcs.size();
+    for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+      const auto &edge = edges_[edge_id];
+      outgoing_.arcs.push_back({edge.to, edge.weight, edge_id});
+    }
+  }
+  outgoing_.offsets.back() = outgoing_.arcs.size();
+
+  incoming_.offsets.resize(vertex_count + 1);
+  if (!with_incoming_arcs) return;
+  incoming_.arcs.reserve(edges_.size());
+  for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+    incoming_.offsets[vertex] = incoming_.arcs.size();
+    for (const EdgeId edge_id : graph.GetIncomingEdges(vertex)) {
+      const auto &edge = edges_[edge_id];
+      incoming_.arcs.push_back({edge.from, edge.weight, edge_id});
+    }
+  }
+  incoming_.offsets.back() = incoming_.arcs.size();
+}
+
+template<typename Weight>
+size_t CsrGraph<Weight>::GetVertexCount() const {
+  return outgoing_.offsets.size() - 1;
+}
+
+template<typename Weight>
+size_t CsrGraph<Weight>::GetEdgeCount() const {
+  return edges_.size();
+}
+
+template<typename Weight>
+const Edge<Weight> &CsrGraph<Weight>::GetEdge(EdgeId edge_id) const {
+  return edges_[edge_id];
+}
+
+template<typename Weight>
+typename CsrGraph<Weight>::ArcsRange
+CsrGraph<Weight>::GetOutgoingArcs(VertexId vertex) const {
+  return outgoing_.Get(vertex);
+}
+
+template<typename Weight>
+typename CsrGraph<Weight>::ArcsRange
+CsrGraph<Weight>::GetIncomingArcs(VertexId vertex) const {
+  return incoming_.Get(vertex);
+}
+
+template<typename Weight>
+typename CsrGraph<Weight>::ArcsRange
+CsrGraph<Weight>::Arcs::Get(VertexId vertex) const {
+  return {arcs.data() + offsets[vertex], arcs.data() + offsets[vertex + 1]};
+}
+}
+
+#endif // GRAPH_CSR_GRAPH_H_
@@ -0,0 +1,15 @@
+#ifndef GRAPH_DIJKSTRA_ROUTER_H_
+#define GRAPH_DIJKSTRA_ROUTER_H_
+
+#include "a_star_router.h"
+
+namespace graph {
+// DijkstraRouter answers every query with a separate binary-heap Dijkstra
+// search, so it needs no precomputation. Prefer it over Router when the graph
+// is too large for an all-pairs table. It is the A* search that settles the
+// vertices in the order of the route weight alone.
+template<typename Weight>
+using DijkstraRouter = AStarRouter<Weight, ZeroHeuristic<Weight>>;
+}
+
+#endif // GRAPH_DIJKSTRA_ROUTER_H_
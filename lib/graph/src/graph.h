@@ -39,29 +39,41 @@ class DirectedWeightedGraph {
  public:
   explicit DirectedWeightedGraph(size_t vertex_count);
   EdgeId AddEdge(const Edge<Weight> &edge);
+  // Routers that copied the graph keep the old weight.
+  void SetEdgeWeight(EdgeId edge_id, Weight weight);
 
   size_t GetVertexCount() const;
   size_t GetEdgeCount() const;
   const Edge<Weight> &GetEdge(EdgeId edge_id) const;
   IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+  // Edges that end at `vertex`, in the order they were added.
+  IncidentEdgesRange GetIncomingEdges(VertexId vertex) const;
 
  private:
   std::vector<Edge<Weight>> edges_;
   std::vector<IncidenceList> incidence_lists_;
+  std::vector<IncidenceList> reverse_incidence_lists_;
 };
 
 template<typename Weight>
 DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
-    : incidence_lists_(vertex_count) {}
+    : incidence_lists_(vertex_count), reverse_incidence_lists_(vertex_count) {}
 
 template<typename Weight>
 EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight> &edge) {
   edges_.push_back(edge);
   const EdgeId id = edges_.size() - 1;
   incidence_lists_[edge.from].push_back(id);
+  reverse_incidence_lists_[edge.to].push_back(id);
   return id;
 }
 
+template<typename Weight>
+void DirectedWeightedGraph<Weight>::SetEdgeWeight(EdgeId edge_id,
+                                                  Weight weight) {
+  edges_[edge_id].weight = weight;
+}
+
 template<typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
   return incidence_lists_.size();
@@ -83,6 +95,13 @@ DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
   const auto &edges = incidence_lists_[vertex];
   return {std::begin(edges), std::end(edges)};
 }
+
+template<typename Weight>
+typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
+DirectedWeightedGraph<Weight>::GetIncomingEdges(VertexId vertex) const {
+  const auto &edges = reverse_incidence_lists_[vertex];
+  return {std::begin(edges), std::end(edges)};
+}
 }
 
 #endif // GRAPH_GRAPH_H_
@@ -0,0 +1,341 @@
+#ifndef GRAPH_HUB_LABEL_ROUTER_H_
+#define GRAPH_HUB_LABEL_ROUTER_H_
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.h"
+#include "graph.h"
+
+namespace graph {
+// HubLabelRouter gives every vertex two labels: hubs it reaches with their
+// distances (out-label) and hubs that reach it (in-label). Any shortest route
+// passes a hub common to the out-label of its source and the in-label of its
+// target, so a query only merges two lists sorted by hub. Labels are built by
+// pruned landmark labeling: a Dijkstra search from every hub, most central
+// first, stops at vertices the previous hubs already cover. Every entry keeps
+// the edge towards its hub, so routes unpack label by label. Weights must be
+// non-negative.
+template<typename Weight>
+class HubLabelRouter {
+ private:
+  using Graph = DirectedWeightedGraph<Weight>;
+
+ public:
+  // Time: O(V*(V'+E')logV'), Mem: O(V+E+L), V' and E' - vertices and edges
+  // a pruned search visits, L - total size of the labels.
+  explicit HubLabelRouter(const Graph &graph);
+
+  // Returns the weight of the route and replaces the content of `edges` with
+  // its edges. Doesn't modify the router, so it may be called concurrently.
+  // Time: O(L'+R*logL'), Mem: O(1) once `edges` has grown, L' - size of the
+  // labels of `from` and `to`, R - size of the route.
+  std::optional<Weight> BuildRoute(VertexId from,
+                                   VertexId to,
+                                   std::vector<EdgeId> &edges) const;
+
+  // Total number of entries in the out- and in-labels.
+  size_t GetLabelEntryCount() const;
+
+ private:
+  static constexpr EdgeId kNoEdge = std::numeric_limits<EdgeId>::max();
+  // Shortest path trees sampled to rank the vertices.
+  static constexpr size_t kSampleTreeCount = 16;
+
+  struct LabelEntry {
+    // Position of the hub in the order the labels were built in.
+    size_t hub_rank;
+    Weight weight;
+    // First edge of the route to the hub in an out-label, last edge of the
+    // route from the hub in an in-label.
+    EdgeId edge_id;
+  };
+
+  using Label = std::vector<LabelEntry>;
+  using QueueItem = std::pair<Weight, VertexId>;
+
+  // Out- (0) and in-labels (1) of all the vertices, packed like CsrGraph:
+  // the label of `vertex` is entries[offsets[vertex]..offsets[vertex + 1]).
+  struct Labels {
+    std::vector<size_t> offsets;
+    std::vector<LabelEntry> entries;
+
+    const LabelEntry *begin(VertexId vertex) const;
+    const LabelEntry *end(VertexId vertex) const;
+    // Entry of `hub_rank` in the label of `vertex`, which must contain it.
+    const LabelEntry &Find(VertexId vertex, size_t hub_rank) const;
+  };
+
+  // Orders the vertices by the number of descendants they have in shortest
+  // path trees from sample roots: a vertex many routes go through covers
+  // them all as a hub.
+  std::vector<VertexId> OrderHubs(const CsrGraph<Weight> &graph);
+  // Runs the pruned search from `hub` forward (side 1, filling in-labels) or
+  // backward (side 0, filling out-labels).
+  void AddHub(const CsrGraph<Weight> &graph,
+              VertexId hub,
+              size_t hub_rank,
+              int side,
+              std::vector<Label> (&labels)[2]);
+
+  const Graph &graph_;
+  Labels labels_[2];
+
+  // State of the construction, released when it is finished.
+  std::vector<std::optional<Weight>> search_weights_;
+  std::vector<EdgeId> search_prev_edges_;
+  std::vector<VertexId> search_visited_;
+  std::vector<QueueItem> search_queue_;
+  // hub_weights_[rank] - weight between the hub searched from and the hub of
+  // `rank`, as found in the label of the former.
+  std::vector<std::optional<Weight>> hub_weights_;
+};
+
+template<typename Weight>
+HubLabelRouter<Weight>::HubLabelRouter(const Graph &graph) : graph_(graph) {
+  const CsrGraph<Weight> csr_graph(graph, true);
+  const size_t vertex_count = graph.GetVertexCount();
+  std::vector<Label> labels[2];
+  labels[0].resize(vertex_count);
+  labels[1].resize(vertex_count);
+  search_weights_.resize(vertex_count);
+  search_prev_edges_.resize(vertex_count);
+  hub_weights_.resize(vertex_count);
+  const std::vector<VertexId> order = OrderHubs(csr_graph);
+  for (size_t rank = 0; rank < vertex_count; ++rank) {
+    AddHub(csr_graph, order[rank], rank, 1, labels);
+    AddHub(csr_graph, order[rank], rank, 0, labels);
+  }
+  search_weights_ = {};
+  search_prev_edges_ = {};
+  hub_weights_ = {};
+
+  for (int side = 0; side < 2; ++side) {
+    auto &packed = labels_[side];
+    packed.offsets.resize(vertex_count + 1);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+      packed.offsets[vertex] = packed.entries.size();
+      packed.entries.insert(packed.entries.end(),
+                            labels[side][vertex].begin(),
+                            labels[side][vertex].end());
+      labels[side][vertex] = {};
+    }
+    packed.offsets.back() = packed.entries.size();
+  }
+}
+
+template<typename Weight>
+std::vector<VertexId> HubLabelRouter<Weight>::OrderHubs(
+    const CsrGraph<Weight> &graph) {
+  const size_t vertex_count = graph.GetVertexCount();
+  std::vector<size_t> descendant_counts(vertex_count);
+  std::vector<size_t> subtree_sizes(vertex_count);
+  std::vector<VertexId> settled;
+  const size_t step = std::max<size_t>(1, vertex_count / kSampleTreeCount);
+  for (VertexId root = 0; root < vertex_count; root += step) {
+    search_weights_[root] = 0;
+    search_prev_edges_[root] = kNoEdge;
+    search_visited_.push_back(root);
+    search_queue_.push_back({0, root});
+    while (!search_queue_.empty()) {
+      std::pop_heap(search_queue_.begin(), search_queue_.end(),
+                    std::greater<>());
+      const auto [weight, vertex] = search_queue_.back();
+      search_queue_.pop_back();
+      if (*search_weights_[vertex] < weight) continue;
+      settled.push_back(vertex);
+      for (const auto &arc : graph.GetOutgoingArcs(vertex)) {
+        const Weight candidate_weight = weight + arc.weight;
+        auto &weight_to = search_weights_[arc.to];
+        if (!weight_to || candidate_weight < *weight_to) {
+          if (!weight_to) search_visited_.push_back(arc.to);
+          weight_to = candidate_weight;
+          search_prev_edges_[arc.to] = arc.edge_id;
+          search_queue_.push_back({candidate_weight, arc.to});
+          std::push_heap(search_queue_.begin(), search_queue_.end(),
+                         std::greater<>());
+        }
+      }
+    }
+
+    // Children are settled after their parents, so the reverse order sums
+    // the subtrees bottom-up.
+    for (auto it = settled.rbegin(); it != settled.rend(); ++it) {
+      subtree_sizes[*it] += 1;
+      descendant_counts[*it] += subtree_sizes[*it];
+      if (const EdgeId edge_id = search_prev_edges_[*it]; edge_id != kNoEdge) {
+        subtree_sizes[graph.GetEdge(edge_id).from] += subtree_sizes[*it];
+      }
+    }
+    for (const VertexId vertex : settled) {
+      subtree_sizes[vertex] = 0;
+    }
+    settled.clear();
+    for (const VertexId vertex : search_visited_) {
+      search_weights_[vertex].reset();
+    }
+    search_visited_.clear();
+  }
+
+  std::vector<VertexId> order(vertex_count);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&](VertexId lhs, VertexId rhs) {
+                     return descendant_counts[lhs] > descendant_counts[rhs];
+                   });
+  return order;
+}
+
+template<typename Weight>
+void HubLabelRouter<Weight>::AddHub(const CsrGraph<Weight> &graph,
+                                    VertexId hub,
+                                    size_t hub_rank,
+                                    int side,
+                                    std::vector<Label> (&labels)[2]) {
+  // The forward search labels routes hub -> vertex, which are covered if an
+  // out-label hub of `hub` is an in-label hub of the vertex; the backward one
+  // is symmetric.
+  for (const auto &entry : labels[side ^ 1][hub]) {
+    hub_weights_[entry.hub_rank] = entry.weight;
+  }
+  const auto covered_weight = [&](VertexId vertex) {
+    std::optional<Weight> result;
+    for (const auto &entry : labels[side][vertex]) {
+      if (const auto &weight = hub_weights_[entry.hub_rank]) {
+        if (!result || *weight + entry.weight < *result) {
+          result = *weight + entry.weight;
+        }
+      }
+    }
+    return result;
+  };
+
+  const auto update = [&](VertexId vertex, Weight weight, EdgeId edge_id) {
+    if (!search_weights_[vertex]) search_visited_.push_back(vertex);
+    search_weights_[vertex] = weight;
+    search_prev_edges_[vertex] = edge_id;
+    search_queue_.push_back({weight, vertex});
+    std::push_heap(search_queue_.begin(), search_queue_.end(),
+                   std::greater<>());
+  };
+
+  update(hub, 0, kNoEdge);
+  while (!search_queue_.empty()) {
+    std::pop_heap(search_queue_.begin(), search_queue_.end(),
+                  std::greater<>());
+    const auto [weight, vertex] = search_queue_.back();
+    search_queue_.pop_back();
+    // Skip stale entries left after the vertex was relaxed again.
+    if (*search_weights_[vertex] < weight) continue;
+    // Routes through the vertex are covered by the earlier hubs as well.
+    if (const auto covered = covered_weight(vertex); covered &&
+        !(weight < *covered)) continue;
+
+    labels[side][vertex].push_back(
+        {hub_rank, weight, search_prev_edges_[vertex]});
+    const auto arcs = side == 1 ? graph.GetOutgoingArcs(vertex)
+                                : graph.GetIncomingArcs(vertex);
+    for (const auto &arc : arcs) {
+      const Weight candidate_weight = weight + arc.weight;
+      const auto &weight_to = search_weights_[arc.to];
+      if (!weight_to || candidate_weight < *weight_to) {
+        update(arc.to, candidate_weight, arc.edge_id);
+      }
+    }
+  }
+
+  for (const VertexId vertex : search_visited_) {
+    search_weights_[vertex].reset();
+  }
+  search_visited_.clear();
+  for (const auto &entry : labels[side ^ 1][hub]) {
+    hub_weights_[entry.hub_rank].reset();
+  }
+}
+
+template<typename Weight>
+const typename HubLabelRouter<Weight>::LabelEntry *
+HubLabelRouter<Weight>::Labels::begin(VertexId vertex) const {
+  return entries.data() + offsets[vertex];
+}
+
+template<typename Weight>
+const typename HubLabelRouter<Weight>::LabelEntry *
+HubLabelRouter<Weight>::Labels::end(VertexId vertex) const {
+  return entries.data() + offsets[vertex + 1];
+}
+
+template<typename Weight>
+const typename HubLabelRouter<Weight>::LabelEntry &
+HubLabelRouter<Weight>::Labels::Find(VertexId vertex, size_t hub_rank) const {
+  return *std::lower_bound(begin(vertex), end(vertex), hub_rank,
+                           [](const LabelEntry &entry, size_t rank) {
+                             return entry.hub_rank < rank;
+                           });
+}
+
+template<typename Weight>
+std::optional<Weight> HubLabelRouter<Weight>::BuildRoute(
+    VertexId from,
+    VertexId to,
+    std::vector<EdgeId> &edges) const {
+  edges.clear();
+  if (from == to) return 0;
+
+  // Both labels are sorted by hub, so their common hubs are found in one
+  // merge.
+  const auto &out_labels = labels_[0];
+  const auto &in_labels = labels_[1];
+  const LabelEntry *out_entry = out_labels.begin(from);
+  const LabelEntry *in_entry = in_labels.begin(to);
+  std::optional<Weight> best_weight;
+  size_t best_hub_rank = 0;
+  while (out_entry != out_labels.end(from) && in_entry != in_labels.end(to)) {
+    if (out_entry->hub_rank < in_entry->hub_rank) {
+      ++out_entry;
+    } else if (in_entry->hub_rank < out_entry->hub_rank) {
+      ++in_entry;
+    } else {
+      const Weight weight = out_entry->weight + in_entry->weight;
+      if (!best_weight || weight < *best_weight) {
+        best_weight = weight;
+        best_hub_rank = out_entry->hub_rank;
+      }
+      ++out_entry;
+      ++in_entry;
+    }
+  }
+  if (!best_weight) return std::nullopt;
+
+  // Every vertex on the route to a hub has the hub in its label, since the
+  // search from the hub went through it.
+  for (EdgeId edge_id = out_labels.Find(from, best_hub_rank).edge_id;
+       edge_id != kNoEdge;) {
+    edges.push_back(edge_id);
+    edge_id = out_labels.Find(graph_.GetEdge(edge_id).to, best_hub_rank)
+        .edge_id;
+  }
+  const size_t middle = edges.size();
+  for (EdgeId edge_id = in_labels.Find(to, best_hub_rank).edge_id;
+       edge_id != kNoEdge;) {
+    edges.push_back(edge_id);
+    edge_id = in_labels.Find(graph_.GetEdge(edge_id).from, best_hub_rank)
+        .edge_id;
+  }
+  std::reverse(std::begin(edges) + middle, std::end(edges));
+  return best_weight;
+}
+
+template<typename Weight>
+size_t HubLabelRouter<Weight>::GetLabelEntryCount() const {
+  return labels_[0].entries.size() + labels_[1].entries.size();
+}
+}
+
+#endif // GRAPH_HUB_LABEL_ROUTER_H_
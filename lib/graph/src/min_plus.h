@@ -0,0 +1,313 @@
+#ifndef GRAPH_MIN_PLUS_H_
+#define GRAPH_MIN_PLUS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include "weight_traits.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define GRAPH_MIN_PLUS_X86 1
+#include <immintrin.h>
+#else
+#define GRAPH_MIN_PLUS_X86 0
+#endif
+
+// Min-plus row update used by the all-pairs precomputation:
+//   weights_from[j] = min(weights_from[j], weight_from + weights_through[j]),
+// copying prev_edges_through[j] into prev_edges_from[j] where the sum wins.
+// The arrays must not overlap. Every kernel gives the same bits as the scalar
+// one: the sums are the same IEEE or saturating integer additions, only done
+// several at a time.
+namespace graph::min_plus {
+// Marks a missing route, see WeightTraits.
+template<typename Weight>
+inline constexpr Weight kNoWeight = WeightTraits<Weight>::kInfinity;
+
+// Fixed-point weights the integer kernels take: 32-bit units, like float.
+template<typename Weight>
+inline constexpr bool kIsFixedPoint32 = false;
+
+template<uint32_t Scale>
+inline constexpr bool kIsFixedPoint32<FixedPoint<uint32_t, Scale>> = true;
+
+enum class Kernel {
+  kScalar = 0,
+  kSse41 = 1,
+  kAvx2 = 2,
+};
+
+template<typename Weight, typename EdgeIdType>
+void RelaxRowScalar(Weight weight_from,
+                    const Weight *__restrict weights_through,
+                    const EdgeIdType *__restrict prev_edges_through,
+                    Weight *__restrict weights_from,
+                    EdgeIdType *__restrict prev_edges_from,
+                    size_t count) {
+  for (size_t idx = 0; idx < count; ++idx) {
+    if constexpr (!WeightTraits<Weight>::kAbsorbsInfinity) {
+      if (weights_through[idx] == kNoWeight<Weight>) continue;
+    }
+    const Weight candidate_weight =
+        WeightTraits<Weight>::Add(weight_from, weights_through[idx]);
+    // Branchless select: the comparison is unpredictable.
+    const bool shorter = candidate_weight < weights_from[idx];
+    weights_from[idx] = shorter ? candidate_weight : weights_from[idx];
+    prev_edges_from[idx] =
+        shorter ? prev_edges_through[idx] : prev_edges_from[idx];
+  }
+}
+
+#if GRAPH_MIN_PLUS_X86
+template<typename EdgeIdType>
+__attribute__((target("sse4.1")))
+void RelaxRowSse41(double weight_from,
+                   const double *__restrict weights_through,
+                   const EdgeIdType *__restrict prev_edges_through,
+                   double *__restrict weights_from,
+                   EdgeIdType *__restrict prev_edges_from,
+                   size_t count) {
+  static_assert(sizeof(EdgeIdType) == sizeof(double));
+  const __m128d weight_from_v = _mm_set1_pd(weight_from);
+  size_t idx = 0;
+  for (; idx + 2 <= count; idx += 2) {
+    const __m128d candidate =
+        _mm_add_pd(weight_from_v, _mm_loadu_pd(weights_through + idx));
+    const __m128d current = _mm_loadu_pd(weights_from + idx);
+    const __m128d shorter = _mm_cmplt_pd(candidate, current);
+    _mm_storeu_pd(weights_from + idx,
+                  _mm_blendv_pd(current, candidate, shorter));
+
+    const __m128d edge_through = _mm_castsi128_pd(_mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(prev_edges_through + idx)));
+    const __m128d edge_from = _mm_castsi128_pd(_mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(prev_edges_from + idx)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(prev_edges_from + idx),
+                     _mm_castpd_si128(
+                         _mm_blendv_pd(edge_from, edge_through, shorter)));
+  }
+  RelaxRowScalar(weight_from, weights_through + idx, prev_edges_through + idx,
+                 weights_from + idx, prev_edges_from + idx, count - idx);
+}
+
+template<typename EdgeIdType>
+__attribute__((target("avx2")))
+void RelaxRowAvx2(double weight_from,
+                  const double *__restrict weights_through,
+                  const EdgeIdType *__restrict prev_edges_through,
+                  double *__restrict weights_from,
+                  EdgeIdType *__restrict prev_edges_from,
+                  size_t count) {
+  static_assert(sizeof(EdgeIdType) == sizeof(double));
+  const __m256d weight_from_v = _mm256_set1_pd(weight_from);
+  size_t idx = 0;
+  for (; idx + 4 <= count; idx += 4) {
+    const __m256d candidate =
+        _mm256_add_pd(weight_from_v, _mm256_loadu_pd(weights_through + idx));
+    const __m256d current = _mm256_loadu_pd(weights_from + idx);
+    const __m256d shorter = _mm256_cmp_pd(candidate, current, _CMP_LT_OQ);
+    _mm256_storeu_pd(weights_from + idx,
+                     _mm256_blendv_pd(current, candidate, shorter));
+
+    const __m256d edge_through = _mm256_castsi256_pd(_mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(prev_edges_through + idx)));
+    const __m256d edge_from = _mm256_castsi256_pd(_mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(prev_edges_from + idx)));
+    const __m256d edge =
+        _mm256_blendv_pd(edge_from, edge_through, shorter);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(prev_edges_from + idx),
+                        _mm256_castpd_si256(edge));
+  }
+  RelaxRowSse41(weight_from, weights_through + idx, prev_edges_through + idx,
+                weights_from + idx, prev_edges_from + idx, count - idx);
+}
+
+template<typename EdgeIdType>
+__attribute__((target("sse4.1")))
+void RelaxRowSse41(float weight_from,
+                   const float *__restrict weights_through,
+                   const EdgeIdType *__restrict prev_edges_through,
+                   float *__restrict weights_from,
+                   EdgeIdType *__restrict prev_edges_from,
+                   size_t count) {
+  static_assert(sizeof(EdgeIdType) == sizeof(float));
+  const __m128 weight_from_v = _mm_set1_ps(weight_from);
+  size_t idx = 0;
+  for (; idx + 4 <= count; idx += 4) {
+    const __m128 candidate =
+        _mm_add_ps(weight_from_v, _mm_loadu_ps(weights_through + idx));
+    const __m128 current = _mm_loadu_ps(weights_from + idx);
+    const __m128 shorter = _mm_cmplt_ps(candidate, current);
+    _mm_storeu_ps(weights_from + idx,
+                  _mm_blendv_ps(current, candidate, shorter));
+
+    const __m128 edge_through = _mm_castsi128_ps(_mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(prev_edges_through + idx)));
+    const __m128 edge_from = _mm_castsi128_ps(_mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(prev_edges_from + idx)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(prev_edges_from + idx),
+                     _mm_castps_si128(
+                         _mm_blendv_ps(edge_from, edge_through, shorter)));
+  }
+  RelaxRowScalar(weight_from, weights_through + idx, prev_edges_through + idx,
+                 weights_from + idx, prev_edges_from + idx, count - idx);
+}
+
+template<typename EdgeIdType>
+__attribute__((target("avx2")))
+void RelaxRowAvx2(float weight_from,
+                  const float *__restrict weights_through,
+                  const EdgeIdType *__restrict prev_edges_through,
+                  float *__restrict weights_from,
+                  EdgeIdType *__restrict prev_edges_from,
+                  size_t count) {
+  static_assert(sizeof(EdgeIdType) == sizeof(float));
+  const __m256 weight_from_v = _mm256_set1_ps(weight_from);
+  size_t idx = 0;
+  for (; idx + 8 <= count; idx += 8) {
+    const __m256 candidate =
+        _mm256_add_ps(weight_from_v, _mm256_loadu_ps(weights_through + idx));
+    const __m256 current = _mm256_loadu_ps(weights_from + idx);
+    const __m256 shorter = _mm256_cmp_ps(candidate, current, _CMP_LT_OQ);
+    _mm256_storeu_ps(weights_from + idx,
+                     _mm256_blendv_ps(current, candidate, shorter));
+
+    const __m256 edge_through = _mm256_castsi256_ps(_mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(prev_edges_through + idx)));
+    const __m256 edge_from = _mm256_castsi256_ps(_mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(prev_edges_from + idx)));
+    const __m256 edge = _mm256_blendv_ps(edge_from, edge_through, shorter);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(prev_edges_from + idx),
+                        _mm256_castps_si256(edge));
+  }
+  RelaxRowSse41(weight_from, weights_through + idx, prev_edges_through + idx,
+                weights_from + idx, prev_edges_from + idx, count - idx);
+}
+
+// Fixed-point kernels. Sums saturate: a lane that wrapped around is below
+// weight_from and is set to all ones, the infinity. SSE and AVX2 compare
+// unsigned lanes only through max: a < b exactly when max(a, b) != a.
+template<typename Weight, typename EdgeIdType>
+__attribute__((target("sse4.1")))
+std::enable_if_t<kIsFixedPoint32<Weight>> RelaxRowSse41(
+    Weight weight_from,
+    const Weight *__restrict weights_through,
+    const EdgeIdType *__restrict prev_edges_through,
+    Weight *__restrict weights_from,
+    EdgeIdType *__restrict prev_edges_from,
+    size_t count) {
+  static_assert(sizeof(EdgeIdType) == sizeof(Weight));
+  const __m128i weight_from_v =
+      _mm_set1_epi32(static_cast<int>(weight_from.GetUnits()));
+  const __m128i ones = _mm_set1_epi32(-1);
+  size_t idx = 0;
+  for (; idx + 4 <= count; idx += 4) {
+    const __m128i sum = _mm_add_epi32(
+        weight_from_v, _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(weights_through + idx)));
+    const __m128i wrapped = _mm_xor_si128(
+        _mm_cmpeq_epi32(_mm_max_epu32(sum, weight_from_v), sum), ones);
+    const __m128i candidate = _mm_or_si128(sum, wrapped);
+    const __m128i current = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(weights_from + idx));
+    const __m128i shorter = _mm_xor_si128(
+        _mm_cmpeq_epi32(_mm_max_epu32(candidate, current), candidate), ones);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(weights_from + idx),
+                     _mm_blendv_epi8(current, candidate, shorter));
+
+    const __m128i edge_through = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(prev_edges_through + idx));
+    const __m128i edge_from = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(prev_edges_from + idx));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(prev_edges_from + idx),
+                     _mm_blendv_epi8(edge_from, edge_through, shorter));
+  }
+  RelaxRowScalar(weight_from, weights_through + idx, prev_edges_through + idx,
+                 weights_from + idx, prev_edges_from + idx, count - idx);
+}
+
+template<typename Weight, typename EdgeIdType>
+__attribute__((target("avx2")))
+std::enable_if_t<kIsFixedPoint32<Weight>> RelaxRowAvx2(
+    Weight weight_from,
+    const Weight *__restrict weights_through,
+    const EdgeIdType *__restrict prev_edges_through,
+    Weight *__restrict weights_from,
+    EdgeIdType *__restrict prev_edges_from,
+    size_t count) {
+  static_assert(sizeof(EdgeIdType) == sizeof(Weight));
+  const __m256i weight_from_v =
+      _mm256_set1_epi32(static_cast<int>(weight_from.GetUnits()));
+  const __m256i ones = _mm256_set1_epi32(-1);
+  size_t idx = 0;
+  for (; idx + 8 <= count; idx += 8) {
+    const __m256i sum = _mm256_add_epi32(
+        weight_from_v, _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(weights_through + idx)));
+    const __m256i wrapped = _mm256_xor_si256(
+        _mm256_cmpeq_epi32(_mm256_max_epu32(sum, weight_from_v), sum), ones);
+    const __m256i candidate = _mm256_or_si256(sum, wrapped);
+    const __m256i current = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(weights_from + idx));
+    const __m256i shorter = _mm256_xor_si256(
+        _mm256_cmpeq_epi32(_mm256_max_epu32(candidate, current), candidate),
+        ones);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(weights_from + idx),
+                        _mm256_blendv_epi8(current, candidate, shorter));
+
+    const __m256i edge_through = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(prev_edges_through + idx));
+    const __m256i edge_from = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(prev_edges_from + idx));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(prev_edges_from + idx),
+                        _mm256_blendv_epi8(edge_from, edge_through, shorter));
+  }
+  RelaxRowSse41(weight_from, weights_through + idx, prev_edges_through + idx,
+                weights_from + idx, prev_edges_from + idx, count - idx);
+}
+#endif
+
+// Returns the widest kernel the running CPU supports.
+inline Kernel DetectKernel() {
+#if GRAPH_MIN_PLUS_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return Kernel::kAvx2;
+  if (__builtin_cpu_supports("sse4.1")) return Kernel::kSse41;
+#endif
+  return Kernel::kScalar;
+}
+
+template<typename Weight, typename EdgeIdType>
+void RelaxRow(Weight weight_from,
+              const Weight *__restrict weights_through,
+              const EdgeIdType *__restrict prev_edges_through,
+              Weight *__restrict weights_from,
+              EdgeIdType *__restrict prev_edges_from,
+              size_t count) {
+#if GRAPH_MIN_PLUS_X86
+  // Vector lanes hold a weight and an edge id of the same width.
+  if constexpr ((std::is_same_v<Weight, double> ||
+      std::is_same_v<Weight, float> || kIsFixedPoint32<Weight>) &&
+      std::is_unsigned_v<EdgeIdType> && sizeof(EdgeIdType) == sizeof(Weight)) {
+    static const Kernel kernel = DetectKernel();
+    switch (kernel) {
+      case Kernel::kAvx2:
+        return RelaxRowAvx2(weight_from, weights_through, prev_edges_through,
+                            weights_from, prev_edges_from, count);
+      case Kernel::kSse41:
+        return RelaxRowSse41(weight_from, weights_through, prev_edges_through,
+                             weights_from, prev_edges_from, count);
+      case Kernel::kScalar:
+        break;
+    }
+  }
+#endif
+  RelaxRowScalar(weight_from, weights_through, prev_edges_through,
+                 weights_from, prev_edges_from, count);
+}
+}
+
+#endif // GRAPH_MIN_PLUS_H_
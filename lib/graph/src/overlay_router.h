@@ -0,0 +1,474 @@
+#ifndef GRAPH_OVERLAY_ROUTER_H_
+#define GRAPH_OVERLAY_ROUTER_H_
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "graph.h"
+#include "thread_pool.h"
+
+namespace graph {
+// OverlayRouter splits the graph into cells of bounded size, groups these
+// cells into larger ones level by level, and keeps, for every cell, the
+// weights of the routes inside it between its boundary vertices, those with
+// edges to or from other cells of its level. A query follows every edge only
+// in the lowest cells of its source and target and crosses any other cell
+// over the clique of the highest level that separates it from both, then
+// unpacks the clique hops one level down at a time. The cells depend only on
+// the edges, the cliques on the weights: after the weights change, Customize
+// recomputes the cliques without touching the cells. Weights must be
+// non-negative.
+template<typename Weight>
+class OverlayRouter {
+ private:
+  using Graph = DirectedWeightedGraph<Weight>;
+
+ public:
+  // `cell_sizes` - the maximal number of vertices in a cell of every level,
+  // lowest first. Time: O(L*(V+E)) plus Customize, Mem: O(L*V+E+sum(B^2)),
+  // L - number of levels, B - number of boundary vertices of a cell.
+  explicit OverlayRouter(const Graph &graph,
+                         const std::vector<size_t> &cell_sizes = {64, 1024},
+                         size_t thread_count = 1);
+
+  // Recomputes the cliques from the current weights of the graph edges, e.g.
+  // after DirectedWeightedGraph::SetEdgeWeight, lowest level first. The
+  // result doesn't depend on `thread_count`. Mustn't run concurrently with
+  // BuildRoute. Time: O(sum(B*(C+A)logC)/T), Mem: O(V) per thread, C and A -
+  // vertices and arcs of the level below inside a cell, T - number of
+  // threads.
+  void Customize(size_t thread_count = 1);
+
+  // Returns the weight of the route and replaces the content of `edges` with
+  // its edges. Counts the settled vertices into `settled_count` if it isn't
+  // null. Doesn't modify the router, so it may be called concurrently.
+  // Time: O((V'+A')logV'+U), Mem: O(V) once per thread, V' and A' -
+  // vertices and arcs searched, U - cost of unpacking the clique hops.
+  std::optional<Weight> BuildRoute(VertexId from,
+                                   VertexId to,
+                                   std::vector<EdgeId> &edges,
+                                   size_t *settled_count = nullptr) const;
+
+  size_t GetLevelCount() const;
+  size_t GetCellCount(size_t level) const;
+  size_t GetBoundaryVertexCount(size_t level) const;
+
+ private:
+  static constexpr EdgeId kNoEdge = std::numeric_limits<EdgeId>::max();
+  static constexpr size_t kNoIndex = std::numeric_limits<size_t>::max();
+
+  using QueueItem = std::pair<Weight, VertexId>;
+
+  struct Cell {
+    std::vector<VertexId> boundary;
+    // Row-major boundary.size()^2 weights of the routes inside the cell.
+    std::vector<std::optional<Weight>> clique;
+  };
+
+  struct Level {
+    std::vector<Cell> cells;
+    std::vector<size_t> cell_ids;
+    // Position of a vertex in the boundary of its cell, kNoIndex if it
+    // isn't there.
+    std::vector<size_t> boundary_ids;
+  };
+
+  // Buffers of a search, indexed by vertex. A vertex reached over a clique
+  // has no previous edge and keeps the vertex the clique was entered at.
+  struct Search {
+    std::vector<std::optional<Weight>> weights;
+    std::vector<EdgeId> prev_edges;
+    std::vector<VertexId> prev_vertices;
+    std::vector<VertexId> visited;
+    std::vector<QueueItem> queue;
+  };
+
+  // Per-thread buffers of BuildRoute and of the searches inside a cell.
+  static Search &GetSearch(size_t vertex_count);
+  static Search &GetCellSearch(size_t vertex_count);
+  static void Update(Search &search,
+                     VertexId vertex,
+                     Weight weight,
+                     EdgeId edge_id,
+                     VertexId prev_vertex);
+  // Pops the queue until an entry that isn't stale.
+  static std::optional<QueueItem> PopSettled(Search &search);
+  static void Reset(Search &search);
+
+  // Groups the cells of the highest level, or the vertices for the first
+  // one, breadth-first over the edges in both directions into cells of at
+  // most `cell_size` vertices, so that cells are connected and compact.
+  void AddLevel(size_t cell_size);
+  // The highest level whose cell of `vertex` holds neither `from` nor `to`.
+  std::optional<size_t> GetQueryLevel(VertexId vertex,
+                                      VertexId from,
+                                      VertexId to) const;
+  // Relaxes the clique row of `vertex` in its cell of `level`.
+  void RelaxClique(size_t level,
+                   VertexId vertex,
+                   Weight weight,
+                   Search &search) const;
+  // Runs Dijkstra from `source` inside its cell of `level` over the cliques
+  // of the level below and the edges between its cells, or over all the
+  // edges for the first level. Stops once `target` is settled if given.
+  void SearchCell(size_t level,
+                  VertexId source,
+                  std::optional<VertexId> target,
+                  Search &search) const;
+  // Appends the edges of the hop from `from` to `to` over the clique of
+  // `level`, reversed.
+  void UnpackHop(size_t level,
+                 VertexId from,
+                 VertexId to,
+                 std::vector<EdgeId> &edges) const;
+
+  const Graph &graph_;
+  std::vector<Level> levels_;
+};
+
+template<typename Weight>
+OverlayRouter<Weight>::OverlayRouter(const Graph &graph,
+                                     const std::vector<size_t> &cell_sizes,
+                                     size_t thread_count)
+    : graph_(graph) {
+  for (const size_t cell_size : cell_sizes) {
+    AddLevel(cell_size);
+  }
+  Customize(thread_count);
+}
+
+template<typename Weight>
+void OverlayRouter<Weight>::AddLevel(size_t cell_size) {
+  const size_t vertex_count = graph_.GetVertexCount();
+  // The cells are made of units: the vertices or the cells of the level
+  // below.
+  std::vector<size_t> unit_ids(vertex_count);
+  for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+    unit_ids[vertex] =
+        levels_.empty() ? vertex : levels_.back().cell_ids[vertex];
+  }
+  const size_t unit_count =
+      levels_.empty() ? vertex_count : levels_.back().cells.size();
+  std::vector<size_t> unit_sizes(unit_count);
+  for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+    ++unit_sizes[unit_ids[vertex]];
+  }
+  std::vector<std::vector<size_t>> neighbors(unit_count);
+  for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+    const auto &edge = graph_.GetEdge(edge_id);
+    const size_t unit_from = unit_ids[edge.from];
+    const size_t unit_to = unit_ids[edge.to];
+    if (unit_from == unit_to) continue;
+    neighbors[unit_from].push_back(unit_to);
+    neighbors[unit_to].push_back(unit_from);
+  }
+
+  std::vector<size_t> unit_cell_ids(unit_count, kNoIndex);
+  std::vector<size_t> cell_units;
+  size_t cell_count = 0;
+  for (size_t root = 0; root < unit_count; ++root) {
+    if (unit_cell_ids[root] != kNoIndex) continue;
+    size_t size = 0;
+    cell_units.clear();
+    const auto add = [&](size_t unit) {
+      if (unit_cell_ids[unit] != kNoIndex ||
+          (size > 0 && size + unit_sizes[unit] > cell_size))
+        return;
+      unit_cell_ids[unit] = cell_count;
+      size += unit_sizes[unit];
+      cell_units.push_back(unit);
+    };
+    add(root);
+    // The units of the cell double as the queue of the search.
+    for (size_t idx = 0; idx < cell_units.size(); ++idx) {
+      for (const size_t neighbor : neighbors[cell_units[idx]]) {
+        add(neighbor);
+      }
+    }
+    ++cell_count;
+  }
+
+  Level &level = levels_.emplace_back();
+  level.cells.resize(cell_count);
+  level.cell_ids.resize(vertex_count);
+  level.boundary_ids.assign(vertex_count, kNoIndex);
+  for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+    level.cell_ids[vertex] = unit_cell_ids[unit_ids[vertex]];
+  }
+  for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+    const auto &edge = graph_.GetEdge(edge_id);
+    if (level.cell_ids[edge.from] == level.cell_ids[edge.to]) continue;
+    for (const VertexId vertex : {edge.from, edge.to}) {
+      if (level.boundary_ids[vertex] != kNoIndex) continue;
+      auto &boundary = level.cells[level.cell_ids[vertex]].boundary;
+      level.boundary_ids[vertex] = boundary.size();
+      boundary.push_back(vertex);
+    }
+  }
+}
+
+template<typename Weight>
+void OverlayRouter<Weight>::Customize(size_t thread_count) {
+  ThreadPool pool(thread_count);
+  const size_t vertex_count = graph_.GetVertexCount();
+  // Every level is searched over the cliques of the one below.
+  for (size_t level = 0; level < levels_.size(); ++level) {
+    auto &cells = levels_[level].cells;
+    pool.ParallelFor(cells.size(), [&](size_t cell_id) {
+      auto &cell = cells[cell_id];
+      const size_t boundary_size = cell.boundary.size();
+      cell.clique.assign(boundary_size * boundary_size, std::nullopt);
+      auto &search = GetCellSearch(vertex_count);
+      for (size_t from = 0; from < boundary_size; ++from) {
+        SearchCell(level, cell.boundary[from], std::nullopt, search);
+        for (size_t to = 0; to < boundary_size; ++to) {
+          cell.clique[from * boundary_size + to] =
+              search.weights[cell.boundary[to]];
+        }
+        Reset(search);
+      }
+    });
+  }
+}
+
+template<typename Weight>
+typename OverlayRouter<Weight>::Search &
+OverlayRouter<Weight>::GetSearch(size_t vertex_count) {
+  thread_local Search search;
+  if (search.weights.size() < vertex_count) {
+    search.weights.resize(vertex_count);
+    search.prev_edges.resize(vertex_count);
+    search.prev_vertices.resize(vertex_count);
+  }
+  return search;
+}
+
+template<typename Weight>
+typename OverlayRouter<Weight>::Search &
+OverlayRouter<Weight>::GetCellSearch(size_t vertex_count) {
+  thread_local Search search;
+  if (search.weights.size() < vertex_count) {
+    search.weights.resize(vertex_count);
+    search.prev_edges.resize(vertex_count);
+    search.prev_vertices.resize(vertex_count);
+  }
+  return search;
+}
+
+template<typename Weight>
+void OverlayRouter<Weight>::Update(Search &search,
+                                   VertexId vertex,
+                                   Weight weight,
+                                   EdgeId edge_id,
+                                   VertexId prev_vertex) {
+  if (!search.weights[vertex]) search.visited.push_back(vertex);
+  search.weights[vertex] = weight;
+  search.prev_edges[vertex] = edge_id;
+  search.prev_vertices[vertex] = prev_vertex;
+  search.queue.push_back({weight, vertex});
+  std::push_heap(search.queue.begin(), search.queue.end(), std::greater<>());
+}
+
+template<typename Weight>
+std::optional<typename OverlayRouter<Weight>::QueueItem>
+OverlayRouter<Weight>::PopSettled(Search &search) {
+  while (!search.queue.empty()) {
+    std::pop_heap(search.queue.begin(), search.queue.end(), std::greater<>());
+    const QueueItem item = search.queue.back();
+    search.queue.pop_back();
+    if (!(*search.weights[item.second] < item.first)) return item;
+  }
+  return std::nullopt;
+}
+
+template<typename Weight>
+void OverlayRouter<Weight>::Reset(Search &search) {
+  for (const VertexId vertex : search.visited) {
+    search.weights[vertex].reset();
+  }
+  search.visited.clear();
+  search.queue.clear();
+}
+
+template<typename Weight>
+std::optional<size_t> OverlayRouter<Weight>::GetQueryLevel(
+    VertexId vertex,
+    VertexId from,
+    VertexId to) const {
+  for (size_t level = levels_.size(); level-- > 0;) {
+    const auto &cell_ids = levels_[level].cell_ids;
+    if (cell_ids[vertex] != cell_ids[from] &&
+        cell_ids[vertex] != cell_ids[to])
+      return level;
+  }
+  return std::nullopt;
+}
+
+template<typename Weight>
+void OverlayRouter<Weight>::RelaxClique(size_t level,
+                                        VertexId vertex,
+                                        Weight weight,
+                                        Search &search) const {
+  const Level &cells = levels_[level];
+  const auto &cell = cells.cells[cells.cell_ids[vertex]];
+  const size_t boundary_size = cell.boundary.size();
+  const auto *clique_row =
+      &cell.clique[cells.boundary_ids[vertex] * boundary_size];
+  for (size_t idx = 0; idx < boundary_size; ++idx) {
+    if (!clique_row[idx] || cell.boundary[idx] == vertex) continue;
+    const VertexId vertex_to = cell.boundary[idx];
+    const Weight candidate_weight = weight + *clique_row[idx];
+    const auto &weight_to = search.weights[vertex_to];
+    if (!weight_to || candidate_weight < *weight_to) {
+      Update(search, vertex_to, candidate_weight, kNoEdge, vertex);
+    }
+  }
+}
+
+template<typename Weight>
+void OverlayRouter<Weight>::SearchCell(size_t level,
+                                       VertexId source,
+                                       std::optional<VertexId> target,
+                                       Search &search) const {
+  const auto &cell_ids = levels_[level].cell_ids;
+  const size_t cell_id = cell_ids[source];
+  const Level *below = level > 0 ? &levels_[level - 1] : nullptr;
+
+  Update(search, source, 0, kNoEdge, source);
+  while (const auto item = PopSettled(search)) {
+    const auto [weight, vertex] = *item;
+    if (target && vertex == *target) break;
+
+    for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+      const auto &edge = graph_.GetEdge(edge_id);
+      if (cell_ids[edge.to] != cell_id ||
+          (below && below->cell_ids[edge.to] == below->cell_ids[vertex]))
+        continue;
+      const Weight candidate_weight = weight + edge.weight;
+      const auto &weight_to = search.weights[edge.to];
+      if (!weight_to || candidate_weight < *weight_to) {
+        Update(search, edge.to, candidate_weight, edge_id, vertex);
+      }
+    }
+    // Cliques hold the shortest routes inside their cells, so a vertex
+    // reached over one leads nowhere new over it.
+    if (below &&
+        (search.prev_edges[vertex] != kNoEdge || vertex == source)) {
+      RelaxClique(level - 1, vertex, weight, search);
+    }
+  }
+}
+
+template<typename Weight>
+void OverlayRouter<Weight>::UnpackHop(size_t level,
+                                      VertexId from,
+                                      VertexId to,
+                                      std::vector<EdgeId> &edges) const {
+  auto &search = GetCellSearch(graph_.GetVertexCount());
+  SearchCell(level, from, to, search);
+  // The hops of the level below reuse the buffers, so the route is taken
+  // out of them first. A hop is an edge if its first vertex is kNoIndex.
+  std::vector<std::pair<VertexId, VertexId>> hops;
+  for (VertexId vertex = to; vertex != from;) {
+    const VertexId prev_vertex = search.prev_vertices[vertex];
+    if (const EdgeId edge_id = search.prev_edges[vertex];
+        edge_id != kNoEdge) {
+      hops.emplace_back(kNoIndex, edge_id);
+    } else {
+      hops.emplace_back(prev_vertex, vertex);
+    }
+    vertex = prev_vertex;
+  }
+  Reset(search);
+
+  for (const auto &[hop_from, hop_to] : hops) {
+    if (hop_from == kNoIndex) {
+      edges.push_back(hop_to);
+    } else {
+      UnpackHop(level - 1, hop_from, hop_to, edges);
+    }
+  }
+}
+
+template<typename Weight>
+std::optional<Weight> OverlayRouter<Weight>::BuildRoute(
+    VertexId from,
+    VertexId to,
+    std::vector<EdgeId> &edges,
+    size_t *settled_count) const {
+  edges.clear();
+  auto &search = GetSearch(graph_.GetVertexCount());
+
+  size_t settled = 0;
+  Update(search, from, 0, kNoEdge, from);
+  while (const auto item = PopSettled(search)) {
+    const auto [weight, vertex] = *item;
+    ++settled;
+    if (vertex == to) break;
+
+    // Outside the lowest cells of the ends, the vertex is on the boundary of
+    // its cell of the query level: the search leaves the cell over the edges
+    // between cells and crosses it over the clique.
+    const auto level = GetQueryLevel(vertex, from, to);
+    for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+      const auto &edge = graph_.GetEdge(edge_id);
+      if (level && levels_[*level].cell_ids[edge.to] ==
+          levels_[*level].cell_ids[vertex])
+        continue;
+      const Weight candidate_weight = weight + edge.weight;
+      const auto &weight_to = search.weights[edge.to];
+      if (!weight_to || candidate_weight < *weight_to) {
+        Update(search, edge.to, candidate_weight, edge_id, vertex);
+      }
+    }
+    if (level && search.prev_edges[vertex] != kNoEdge) {
+      RelaxClique(*level, vertex, weight, search);
+    }
+  }
+
+  const std::optional<Weight> weight = search.weights[to];
+  if (weight) {
+    for (VertexId vertex = to; vertex != from;) {
+      const VertexId prev_vertex = search.prev_vertices[vertex];
+      if (const EdgeId edge_id = search.prev_edges[vertex];
+          edge_id != kNoEdge) {
+        edges.push_back(edge_id);
+      } else {
+        UnpackHop(*GetQueryLevel(prev_vertex, from, to), prev_vertex, vertex,
+                  edges);
+      }
+      vertex = prev_vertex;
+    }
+    std::reverse(std::begin(edges), std::end(edges));
+  }
+  Reset(search);
+  if (settled_count) *settled_count = settled;
+  return weight;
+}
+
+template<typename Weight>
+size_t OverlayRouter<Weight>::GetLevelCount() const {
+  return levels_.size();
+}
+
+template<typename Weight>
+size_t OverlayRouter<Weight>::GetCellCount(size_t level) const {
+  return levels_[level].cells.size();
+}
+
+template<typename Weight>
+size_t OverlayRouter<Weight>::GetBoundaryVertexCount(size_t level) const {
+  size_t count = 0;
+  for (const auto &cell : levels_[level].cells) {
+    count += cell.boundary.size();
+  }
+  return count;
+}
+}
+
+#endif // GRAPH_OVERLAY_ROUTER_H_
@@ -5,148 +5,459 @@
 #include <cassert>
 #include <cstdint>
 #include <iterator>
+#include <limits>
 #include <optional>
-#include <unordered_map>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 #include "graph.h"
+#include "min_plus.h"
+#include "thread_pool.h"
+#include "weight_traits.h"
 
 namespace graph {
-template<typename Weight>
+// Router precomputes all the routes with Floyd-Warshall, separately in every
+// weakly connected component of the graph: routes never leave a component, so
+// the pairs across components need no cells and are answered in O(1). The
+// tables keep weights as StoredWeight and edge ids as StoredEdgeId, so
+// narrower types trade precision of the route choice for memory. When
+// StoredWeight differs from Weight, BuildRoute and GetWeight sum the reported
+// weight from the route edges.
+template<typename Weight,
+    typename StoredWeight = Weight,
+    typename StoredEdgeId = EdgeId>
 class Router {
  private:
   using Graph = DirectedWeightedGraph<Weight>;
 
  public:
-  // Time: O(V^3+E), Mem: O(V^2), V - number of vertices, E - number of edges.
-  explicit Router(const Graph &graph);
+  // Time: O(sum(C^3)/T+E), Mem: O(sum(C^2)+V), C - number of vertices in a
+  // component, E - number of edges, T - number of threads running the
+  // precomputation. The result doesn't depend on `thread_count`. The graph
+  // must have fewer edges than StoredEdgeId can number.
+  explicit Router(const Graph &graph, size_t thread_count = 1);
+  // Wraps tables taken with GetWeights and GetPrevEdges from a router of the
+  // same graph, e.g. mapped from a file. They must outlive the router.
+  // Time: O(V+E), Mem: O(V).
+  Router(const Graph &graph,
+         const StoredWeight *weights,
+         const StoredEdgeId *prev_edges);
 
-  using RouteId = uint64_t;
+  // Returns the weight of the route and replaces the content of `edges` with
+  // its edges. Doesn't modify the router, so it may be called concurrently.
+  // Time: O(R), Mem: O(1) once `edges` has grown, R - size of the route.
+  std::optional<Weight> BuildRoute(VertexId from,
+                                   VertexId to,
+                                   std::vector<EdgeId> &edges) const;
+  // Returns the weight BuildRoute would, without collecting the route. The
+  // summed weights are added in reverse, so they may differ in rounding.
+  // Time: O(1) when StoredWeight is Weight, O(R) otherwise, Mem: O(1).
+  std::optional<Weight> GetWeight(VertexId from, VertexId to) const;
 
-  struct RouteInfo {
-    RouteId id;
-    Weight weight;
-    size_t edge_count;
-  };
+  // Updates the tables after `edge_id` was added to the graph or its weight
+  // was decreased, so that they hold the weights a new router would. Routes of
+  // equal weight may be chosen differently. External tables are copied first.
+  // Weights must be non-negative.
+  // Time: O(C^2), or O(sum(C^2)+V+E) when the edge joins two components,
+  // Mem: O(C).
+  void UpdateEdge(EdgeId edge_id);
+  // Recomputes the tables from the graph. A weight increase needs it: any
+  // route may have gone through the edge, and other routes aren't kept.
+  // Time and Mem: as for the constructor.
+  void Rebuild(size_t thread_count = 1);
 
-  // Time: O(R), Mem: O(R), R - size of the route.
-  std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
-  // Time: O(1), Mem: O(1).
-  EdgeId GetRouteEdge(RouteId route_id, size_t edge_idx) const;
-  // Time: O(1), Mem: O(1).
-  void ReleaseRoute(RouteId route_id);
+  // Checks that external tables, e.g. read from a damaged file, are safe to
+  // query: every route edge is an edge of the graph ending at the vertex of
+  // its cell, and the route edges lead back to the source without a cycle.
+  // Time: O(sum(C^2)), Mem: O(V).
+  bool CheckTables() const;
+
+  // Tables of the router, GetCellCount() cells each, see weights_ and
+  // prev_edges_.
+  const StoredWeight *GetWeights() const { return weights_data_; }
+  const StoredEdgeId *GetPrevEdges() const { return prev_edges_data_; }
+  size_t GetCellCount() const { return components_.back().cell_offset; }
+  size_t GetComponentCount() const { return components_.size() - 1; }
 
  private:
-  const Graph &graph_;
+  // Marks a missing route in weights_ and a route without edges in
+  // prev_edges_.
+  static constexpr StoredWeight kNoWeight = min_plus::kNoWeight<StoredWeight>;
+  static constexpr StoredEdgeId kNoEdge =
+      std::numeric_limits<StoredEdgeId>::max();
+  // Side of the square tiles the matrices are relaxed by, so that the three
+  // tiles used by RelaxBlock stay in L1/L2 cache.
+  static constexpr size_t kBlockSize = 64;
 
-  struct RouteInternalData {
-    Weight weight;
-    std::optional<EdgeId> prev_edge;
+  // Cells of a component are the row-major size*size table at cell_offset.
+  struct Component {
+    size_t size;
+    size_t cell_offset;
   };
-  using RoutesInternalData = std::vector<std::vector<std::optional<
-      RouteInternalData>>>;
 
-  using ExpandedRoute = std::vector<EdgeId>;
-  mutable RouteId next_route_id_ = 0;
-  mutable std::unordered_map<RouteId, ExpandedRoute> expanded_routes_cache_;
+  const Graph &graph_;
+  const size_t vertex_count_;
+
+  size_t Index(VertexId from, VertexId to) const {
+    const auto &component = components_[component_ids_[from]];
+    return component.cell_offset + local_ids_[from] * component.size +
+        local_ids_[to];
+  }
+
+  // Splits the vertices into weakly connected components, keeping their order
+  // within a component. The split depends only on the graph, so the external
+  // tables are laid out the same way.
+  void FindComponents() {
+    const size_t no_component = vertex_count_;
+    component_ids_.assign(vertex_count_, no_component);
+    std::vector<size_t> sizes;
+    std::vector<VertexId> stack;
+    for (VertexId root = 0; root < vertex_count_; ++root) {
+      if (component_ids_[root] != no_component) continue;
+      const size_t component_id = sizes.size();
+      sizes.push_back(0);
+      component_ids_[root] = component_id;
+      stack.push_back(root);
+      while (!stack.empty()) {
+        const VertexId vertex = stack.back();
+        stack.pop_back();
+        ++sizes.back();
+        const auto visit = [&](VertexId neighbor) {
+          if (component_ids_[neighbor] != no_component) return;
+          component_ids_[neighbor] = component_id;
+          stack.push_back(neighbor);
+        };
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+          visit(graph_.GetEdge(edge_id).to);
+        }
+        for (const EdgeId edge_id : graph_.GetIncomingEdges(vertex)) {
+          visit(graph_.GetEdge(edge_id).from);
+        }
+      }
+    }
+
+    // The extra component past the end marks the end of the cells.
+    components_.resize(sizes.size() + 1);
+    size_t cell_offset = 0;
+    for (size_t id = 0; id <= sizes.size(); ++id) {
+      components_[id] = {0, cell_offset};
+      if (id < sizes.size()) cell_offset += sizes[id] * sizes[id];
+    }
+    local_ids_.resize(vertex_count_);
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+      local_ids_[vertex] = components_[component_ids_[vertex]].size++;
+    }
+  }
 
   void InitializeRoutesInternalData() {
-    const size_t vertex_count = graph_.GetVertexCount();
-    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-      routes_internal_data_[vertex][vertex] =
-          RouteInternalData{0, std::nullopt};
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+      weights_[Index(vertex, vertex)] = StoredWeight{};
       for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
         const auto &edge = graph_.GetEdge(edge_id);
-        auto &route_internal_data = routes_internal_data_[vertex][edge.to];
-        if (!route_internal_data || route_internal_data->weight > edge.weight) {
-          route_internal_data = RouteInternalData{edge.weight, edge_id};
+        const size_t idx = Index(vertex, edge.to);
+        const auto weight = static_cast<StoredWeight>(edge.weight);
+        if (weights_[idx] == kNoWeight || weights_[idx] > weight) {
+          weights_[idx] = weight;
+          prev_edges_[idx] = static_cast<StoredEdgeId>(edge_id);
         }
       }
     }
   }
 
-  void RelaxRoute(VertexId vertex_from,
-                  VertexId vertex_to,
-                  const RouteInternalData &route_from,
-                  const RouteInternalData &route_to) {
-    auto &route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-    const Weight candidate_weight = route_from.weight + route_to.weight;
-    if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-      route_relaxing = {
-          candidate_weight,
-          route_to.prev_edge
-          ? route_to.prev_edge
-          : route_from.prev_edge
-      };
+  // Relaxes the routes from every vertex of `block_from` to every vertex of
+  // `block_to` through the vertices of `block_through`, in increasing order.
+  // Blocks are numbered within `component`.
+  void RelaxBlock(const Component &component,
+                  size_t block_from,
+                  size_t block_to,
+                  size_t block_through) {
+    const size_t size = component.size;
+    StoredWeight *weights = &weights_[component.cell_offset];
+    StoredEdgeId *prev_edges = &prev_edges_[component.cell_offset];
+    const size_t from_end = std::min(size, (block_from + 1) * kBlockSize);
+    const size_t to_begin = block_to * kBlockSize;
+    const size_t to_end = std::min(size, to_begin + kBlockSize);
+    const size_t through_end =
+        std::min(size, (block_through + 1) * kBlockSize);
+    for (size_t through = block_through * kBlockSize; through < through_end;
+         ++through) {
+      const StoredWeight *weights_through = &weights[through * size];
+      const StoredEdgeId *prev_edges_through = &prev_edges[through * size];
+      for (size_t from = block_from * kBlockSize; from < from_end; ++from) {
+        const StoredWeight weight_from = weights[from * size + through];
+        // The row of `through` can't be shortened through itself, so
+        // skipping it also keeps the rows passed to RelaxRow apart.
+        if (weight_from == kNoWeight || from == through) continue;
+
+        min_plus::RelaxRow(weight_from,
+                           weights_through + to_begin,
+                           prev_edges_through + to_begin,
+                           &weights[from * size + to_begin],
+                           &prev_edges[from * size + to_begin],
+                           to_end - to_begin);
+      }
     }
   }
 
-  void RelaxRoutesInternalDataThroughVertex(VertexId vertex_through) {
-    size_t vertex_count = graph_.GetVertexCount();
-    for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-      if (const auto
-          &route_from = routes_internal_data_[vertex_from][vertex_through]) {
-        for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-          if (const auto
-              &route_to = routes_internal_data_[vertex_through][vertex_to]) {
-            RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
+  // Blocked Floyd-Warshall over every component: for every diagonal tile,
+  // first closes the tile itself, then the tiles of its row and column, then
+  // all the rest. Tiles of the same phase don't read each other's cells, so
+  // they are relaxed in parallel without changing the result.
+  void RelaxRoutesInternalData(ThreadPool &pool) {
+    for (size_t id = 0; id < GetComponentCount(); ++id) {
+      const Component &component = components_[id];
+      const size_t block_count = (component.size + kBlockSize - 1) / kBlockSize;
+      for (size_t block_through = 0; block_through < block_count;
+           ++block_through) {
+        RelaxBlock(component, block_through, block_through, block_through);
+        pool.ParallelFor(2 * block_count, [&](size_t task) {
+          const size_t block = task / 2;
+          if (block == block_through) return;
+          if (task % 2 == 0) {
+            RelaxBlock(component, block_through, block, block_through);
+          } else {
+            RelaxBlock(component, block, block_through, block_through);
           }
-        }
+        });
+        pool.ParallelFor(block_count, [&](size_t block_from) {
+          if (block_from == block_through) return;
+          for (size_t block_to = 0; block_to < block_count; ++block_to) {
+            if (block_to == block_through) continue;
+            RelaxBlock(component, block_from, block_to, block_through);
+          }
+        });
       }
     }
   }
 
-  RoutesInternalData routes_internal_data_;
+  // Lays the tables out anew after an edge joined two components.
+  void MergeComponents();
+
+  std::vector<Component> components_;
+  // Component of every vertex and its position there.
+  std::vector<size_t> component_ids_;
+  std::vector<size_t> local_ids_;
+  // Component tables one after another: weights_[Index(from, to)] is the
+  // weight of the shortest route and prev_edges_[Index(from, to)] is its last
+  // edge.
+  std::vector<StoredWeight> weights_;
+  std::vector<StoredEdgeId> prev_edges_;
+  // The tables queried by BuildRoute: either the two above or external ones.
+  const StoredWeight *weights_data_;
+  const StoredEdgeId *prev_edges_data_;
 };
 
+// Router with 4-byte cells: float weights and 32-bit edge ids take a quarter
+// of the memory of double weights with size_t edge ids. Routes whose weights
+// differ by less than float precision may be chosen differently.
+template<typename Weight>
+using CompactRouter = Router<Weight, float, uint32_t>;
+
+// Router with 4-byte cells holding integer weights in thousandths of the
+// Weight unit, which the precomputation adds and compares faster than floats.
+// Each edge weight is rounded to the nearest unit, so routes within the
+// rounding of each other may be chosen differently.
 template<typename Weight>
-Router<Weight>::Router(const Graph &graph)
+using FixedPointRouter =
+    Router<Weight, FixedPoint<uint32_t, 1000>, uint32_t>;
+
+template<typename Weight, typename StoredWeight, typename StoredEdgeId>
+Router<Weight, StoredWeight, StoredEdgeId>::Router(const Graph &graph,
+                                                   size_t thread_count)
     : graph_(graph),
-      routes_internal_data_(
-          graph.GetVertexCount(),
-          std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount())) {
+      vertex_count_(graph.GetVertexCount()) {
+  Rebuild(thread_count);
+}
+
+template<typename Weight, typename StoredWeight, typename StoredEdgeId>
+Router<Weight, StoredWeight, StoredEdgeId>::Router(
+    const Graph &graph,
+    const StoredWeight *weights,
+    const StoredEdgeId *prev_edges)
+    : graph_(graph),
+      vertex_count_(graph.GetVertexCount()),
+      weights_data_(weights),
+      prev_edges_data_(prev_edges) {
+  FindComponents();
+}
+
+template<typename Weight, typename StoredWeight, typename StoredEdgeId>
+void Router<Weight, StoredWeight, StoredEdgeId>::Rebuild(size_t thread_count) {
+  assert(graph_.GetEdgeCount() < kNoEdge);
+  FindComponents();
+  weights_.assign(GetCellCount(), kNoWeight);
+  prev_edges_.assign(GetCellCount(), kNoEdge);
   InitializeRoutesInternalData();
+  ThreadPool pool(thread_count);
+  RelaxRoutesInternalData(pool);
+  weights_data_ = weights_.data();
+  prev_edges_data_ = prev_edges_.data();
+}
+
+template<typename Weight, typename StoredWeight, typename StoredEdgeId>
+void Router<Weight, StoredWeight, StoredEdgeId>::UpdateEdge(EdgeId edge_id) {
+  assert(graph_.GetEdgeCount() < kNoEdge);
+  if (weights_data_ != weights_.data()) {
+    weights_.assign(weights_data_, weights_data_ + GetCellCount());
+    prev_edges_.assign(prev_edges_data_, prev_edges_data_ + GetCellCount());
+  }
+  const auto &edge = graph_.GetEdge(edge_id);
+  if (component_ids_[edge.from] != component_ids_[edge.to]) {
+    MergeComponents();
+  }
+  weights_data_ = weights_.data();
+  prev_edges_data_ = prev_edges_.data();
+  // Loops never shorten a route.
+  if (edge.from == edge.to) return;
+
+  // The new routes are (x -> from) + edge + (to -> y). With non-negative
+  // weights neither part goes through the edge, so they are read up front.
+  const Component &component = components_[component_ids_[edge.from]];
+  const size_t size = component.size;
+  StoredWeight *weights = &weights_[component.cell_offset];
+  StoredEdgeId *prev_edges = &prev_edges_[component.cell_offset];
+  const size_t from = local_ids_[edge.from];
+  const size_t to = local_ids_[edge.to];
+  std::vector<StoredWeight> weights_to_from(size);
+  for (size_t vertex = 0; vertex < size; ++vertex) {
+    weights_to_from[vertex] = weights[vertex * size + from];
+  }
+  const std::vector<StoredWeight> weights_from_to(
+      weights + to * size, weights + (to + 1) * size);
+  std::vector<StoredEdgeId> prev_edges_from_to(
+      prev_edges + to * size, prev_edges + (to + 1) * size);
+  prev_edges_from_to[to] = static_cast<StoredEdgeId>(edge_id);
 
-  const size_t vertex_count = graph.GetVertexCount();
-  for (VertexId vertex_through = 0; vertex_through < vertex_count;
-       ++vertex_through) {
-    RelaxRoutesInternalDataThroughVertex(vertex_through);
+  const auto weight = static_cast<StoredWeight>(edge.weight);
+  for (size_t vertex = 0; vertex < size; ++vertex) {
+    if (weights_to_from[vertex] == kNoWeight) continue;
+    min_plus::RelaxRow(WeightTraits<StoredWeight>::Add(
+                           weights_to_from[vertex], weight),
+                       weights_from_to.data(),
+                       prev_edges_from_to.data(),
+                       &weights[vertex * size],
+                       &prev_edges[vertex * size],
+                       size);
   }
 }
 
-template<typename Weight>
-std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(
+template<typename Weight, typename StoredWeight, typename StoredEdgeId>
+void Router<Weight, StoredWeight, StoredEdgeId>::MergeComponents() {
+  const auto old_components = std::move(components_);
+  const auto old_component_ids = std::move(component_ids_);
+  const auto old_local_ids = std::move(local_ids_);
+  const auto old_weights = std::move(weights_);
+  const auto old_prev_edges = std::move(prev_edges_);
+  FindComponents();
+  weights_.assign(GetCellCount(), kNoWeight);
+  prev_edges_.assign(GetCellCount(), kNoEdge);
+
+  // Routes inside an old component stay as they are.
+  std::vector<std::vector<VertexId>> members(old_components.size() - 1);
+  for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+    members[old_component_ids[vertex]].push_back(vertex);
+  }
+  for (size_t id = 0; id + 1 < old_components.size(); ++id) {
+    const Component &component = old_components[id];
+    for (const VertexId from : members[id]) {
+      for (const VertexId to : members[id]) {
+        const size_t old_idx = component.cell_offset +
+            old_local_ids[from] * component.size + old_local_ids[to];
+        weights_[Index(from, to)] = old_weights[old_idx];
+        prev_edges_[Index(from, to)] = old_prev_edges[old_idx];
+      }
+    }
+  }
+}
+
+template<typename Weight, typename StoredWeight, typename StoredEdgeId>
+std::optional<Weight> Router<Weight, StoredWeight, StoredEdgeId>::GetWeight(
     VertexId from,
     VertexId to) const {
-  const auto &route_internal_data = routes_internal_data_[from][to];
-  if (!route_internal_data) {
+  if (component_ids_[from] != component_ids_[to]) return std::nullopt;
+  const StoredWeight stored_weight = weights_data_[Index(from, to)];
+  if (stored_weight == kNoWeight) {
     return std::nullopt;
   }
-  const Weight weight = route_internal_data->weight;
-  std::vector<EdgeId> edges;
-  for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-       edge_id;
-       edge_id =
-           routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge) {
-    edges.push_back(*edge_id);
-  }
-  std::reverse(std::begin(edges), std::end(edges));
 
-  const RouteId route_id = next_route_id_++;
-  const size_t route_edge_count = edges.size();
-  expanded_routes_cache_[route_id] = std::move(edges);
-  return RouteInfo{route_id, weight, route_edge_count};
+  if constexpr (std::is_same_v<Weight, StoredWeight>) {
+    return stored_weight;
+  } else {
+    Weight weight{};
+    for (StoredEdgeId edge_id = prev_edges_data_[Index(from, to)];
+         edge_id != kNoEdge;) {
+      const auto &edge = graph_.GetEdge(edge_id);
+      weight += edge.weight;
+      edge_id = prev_edges_data_[Index(from, edge.from)];
+    }
+    return weight;
+  }
 }
 
-template<typename Weight>
-EdgeId Router<Weight>::GetRouteEdge(RouteId route_id, size_t edge_idx) const {
-  return expanded_routes_cache_.at(route_id)[edge_idx];
+template<typename Weight, typename StoredWeight, typename StoredEdgeId>
+bool Router<Weight, StoredWeight, StoredEdgeId>::CheckTables() const {
+  std::vector<std::vector<VertexId>> members(GetComponentCount());
+  for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+    members[component_ids_[vertex]].push_back(vertex);
+  }
+  // The state of `to` while the route edges to it are followed from `from`.
+  enum class State : uint8_t { kNew, kOnPath, kChecked };
+  std::vector<State> states(vertex_count_);
+  std::vector<VertexId> path;
+  for (const auto &component : members) {
+    for (const VertexId from : component) {
+      for (const VertexId to : component) states[to] = State::kNew;
+      for (const VertexId start : component) {
+        VertexId to = start;
+        while (states[to] == State::kNew) {
+          states[to] = State::kOnPath;
+          path.push_back(to);
+          const StoredEdgeId edge_id = prev_edges_data_[Index(from, to)];
+          if (edge_id == kNoEdge) break;
+          if (edge_id >= graph_.GetEdgeCount()) return false;
+          const auto &edge = graph_.GetEdge(edge_id);
+          if (edge.to != to) return false;
+          to = edge.from;
+        }
+        if (states[to] == State::kOnPath &&
+            prev_edges_data_[Index(from, to)] != kNoEdge)
+          return false;
+        for (const VertexId vertex : path) states[vertex] = State::kChecked;
+        path.clear();
+      }
+    }
+  }
+  return true;
 }
 
-template<typename Weight>
-void Router<Weight>::ReleaseRoute(RouteId route_id) {
-  expanded_routes_cache_.erase(route_id);
+template<typename Weight, typename StoredWeight, typename StoredEdgeId>
+std::optional<Weight> Router<Weight, StoredWeight, StoredEdgeId>::BuildRoute(
+    VertexId from,
+    VertexId to,
+    std::vector<EdgeId> &edges) const {
+  edges.clear();
+  if (component_ids_[from] != component_ids_[to]) return std::nullopt;
+  const StoredWeight stored_weight = weights_data_[Index(from, to)];
+  if (stored_weight == kNoWeight) {
+    return std::nullopt;
+  }
+  for (StoredEdgeId edge_id = prev_edges_data_[Index(from, to)];
+       edge_id != kNoEdge;
+       edge_id = prev_edges_data_[Index(from, graph_.GetEdge(edge_id).from)]) {
+    edges.push_back(edge_id);
+  }
+  std::reverse(std::begin(edges), std::end(edges));
+
+  if constexpr (std::is_same_v<Weight, StoredWeight>) {
+    return stored_weight;
+  } else {
+    Weight weight{};
+    for (const EdgeId edge_id : edges) {
+      weight += graph_.GetEdge(edge_id).weight;
+    }
+    return weight;
+  }
 }
 }
 
@@ -0,0 +1,96 @@
+#ifndef GRAPH_SHORTEST_PATH_TREE_H_
+#define GRAPH_SHORTEST_PATH_TREE_H_
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.h"
+#include "graph.h"
+
+namespace graph {
+// ShortestPathTree finds the routes from one root to every vertex with a
+// single Dijkstra search, so one-to-many queries pay for one search instead
+// of one per target. Weights must be non-negative.
+template<typename Weight>
+class ShortestPathTree {
+ public:
+  // Time: O(V), Mem: O(V).
+  explicit ShortestPathTree(const CsrGraph<Weight> &graph);
+
+  // Replaces the tree with the one rooted at `root`.
+  // Time: O((V+E)logV), Mem: O(V+E).
+  void Build(VertexId root);
+
+  // Time: O(1), Mem: O(1).
+  std::optional<Weight> GetWeight(VertexId to) const;
+  // Replaces the content of `edges` with the route from the root to `to`.
+  // Leaves it empty if `to` is unreachable. Time: O(R), R - size of the route.
+  void GetRoute(VertexId to, std::vector<EdgeId> &edges) const;
+
+ private:
+  static constexpr EdgeId kNoEdge = std::numeric_limits<EdgeId>::max();
+
+  const CsrGraph<Weight> &graph_;
+  std::vector<std::optional<Weight>> weights_;
+  // prev_edges_[vertex] - the last edge of the route to vertex.
+  std::vector<EdgeId> prev_edges_;
+};
+
+template<typename Weight>
+ShortestPathTree<Weight>::ShortestPathTree(const CsrGraph<Weight> &graph)
+    : graph_(graph),
+      weights_(graph.GetVertexCount()),
+      prev_edges_(graph.GetVertexCount(), kNoEdge) {}
+
+template<typename Weight>
+void ShortestPathTree<Weight>::Build(VertexId root) {
+  std::fill(weights_.begin(), weights_.end(), std::nullopt);
+  std::fill(prev_edges_.begin(), prev_edges_.end(), kNoEdge);
+
+  using QueueItem = std::pair<Weight, VertexId>;
+  std::vector<QueueItem> queue = {{0, root}};
+  weights_[root] = 0;
+  while (!queue.empty()) {
+    std::pop_heap(queue.begin(), queue.end(), std::greater<>());
+    const auto [weight, vertex] = queue.back();
+    queue.pop_back();
+    // Skip stale entries left after the vertex was relaxed again.
+    if (*weights_[vertex] < weight) continue;
+
+    for (const auto &arc : graph_.GetOutgoingArcs(vertex)) {
+      const Weight candidate_weight = weight + arc.weight;
+      auto &weight_to = weights_[arc.to];
+      if (!weight_to || candidate_weight < *weight_to) {
+        weight_to = candidate_weight;
+        prev_edges_[arc.to] = arc.edge_id;
+        queue.push_back({candidate_weight, arc.to});
+        std::push_heap(queue.begin(), queue.end(), std::greater<>());
+      }
+    }
+  }
+}
+
+template<typename Weight>
+std::optional<Weight> ShortestPathTree<Weight>::GetWeight(VertexId to) const {
+  return weights_[to];
+}
+
+template<typename Weight>
+void ShortestPathTree<Weight>::GetRoute(VertexId to,
+                                        std::vector<EdgeId> &edges) const {
+  edges.clear();
+  if (!weights_[to]) return;
+  for (EdgeId edge_id = prev_edges_[to]; edge_id != kNoEdge;
+       edge_id = prev_edges_[graph_.GetEdge(edge_id).from]) {
+    edges.push_back(edge_id);
+  }
+  std::reverse(std::begin(edges), std::end(edges));
+}
+}
+
+#endif // GRAPH_SHORTEST_PATH_TREE_H_
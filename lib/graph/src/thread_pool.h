@@ -0,0 +1,120 @@
+#ifndef GRAPH_THREAD_POOL_H_
+#define GRAPH_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace graph {
+// ThreadPool keeps `thread_count - 1` workers alive and runs index ranges on
+// them together with the calling thread. ParallelFor must not be called
+// concurrently from several threads.
+class ThreadPool {
+ public:
+  explicit ThreadPool(size_t thread_count);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  size_t GetThreadCount() const;
+
+  // Calls func(idx) for every idx in [0, count) and returns when all the calls
+  // are finished, so consecutive calls are separated by a barrier.
+  template<typename Func>
+  void ParallelFor(size_t count, Func func);
+
+ private:
+  void WorkerLoop();
+  void RunTask();
+
+  std::vector<std::thread> workers_;
+
+  std::mutex mutex_;
+  std::condition_variable task_ready_;
+  std::condition_variable task_done_;
+  uint64_t generation_ = 0;
+  size_t busy_workers_ = 0;
+  bool stopping_ = false;
+
+  const std::function<void(size_t)> *task_ = nullptr;
+  size_t task_size_ = 0;
+  std::atomic<size_t> next_idx_ = 0;
+};
+
+inline ThreadPool::ThreadPool(size_t thread_count) {
+  for (size_t i = 1; i < thread_count; ++i) {
+    workers_.emplace_back([this] { WorkerLoop(); });
+  }
+}
+
+inline ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  task_ready_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+inline size_t ThreadPool::GetThreadCount() const {
+  return workers_.size() + 1;
+}
+
+template<typename Func>
+void ThreadPool::ParallelFor(size_t count, Func func) {
+  if (workers_.empty() || count <= 1) {
+    for (size_t idx = 0; idx < count; ++idx) {
+      func(idx);
+    }
+    return;
+  }
+
+  const std::function<void(size_t)> task = std::move(func);
+  {
+    std::lock_guard lock(mutex_);
+    task_ = &task;
+    task_size_ = count;
+    next_idx_ = 0;
+    busy_workers_ = workers_.size();
+    ++generation_;
+  }
+  task_ready_.notify_all();
+  RunTask();
+
+  std::unique_lock lock(mutex_);
+  task_done_.wait(lock, [this] { return busy_workers_ == 0; });
+  task_ = nullptr;
+}
+
+inline void ThreadPool::WorkerLoop() {
+  uint64_t seen_generation = 0;
+  std::unique_lock lock(mutex_);
+  while (true) {
+    task_ready_.wait(lock, [&] {
+      return stopping_ || generation_ != seen_generation;
+    });
+    if (stopping_) return;
+    seen_generation = generation_;
+
+    lock.unlock();
+    RunTask();
+    lock.lock();
+    if (--busy_workers_ == 0) task_done_.notify_one();
+  }
+}
+
+inline void ThreadPool::RunTask() {
+  for (size_t idx = next_idx_++; idx < task_size_; idx = next_idx_++) {
+    (*task_)(idx);
+  }
+}
+}
+
+#endif // GRAPH_THREAD_POOL_H_
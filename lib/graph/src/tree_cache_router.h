@@ -0,0 +1,124 @@
+#ifndef GRAPH_TREE_CACHE_ROUTER_H_
+#define GRAPH_TREE_CACHE_ROUTER_H_
+
+#include <cassert>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.h"
+#include "graph.h"
+#include "shortest_path_tree.h"
+
+namespace graph {
+// TreeCacheRouter builds the shortest path tree of a source the first time a
+// route from it is asked for and keeps the `capacity` most recently used
+// trees, so repeated sources are answered without a search. Each tree takes
+// O(V) memory. Weights must be non-negative.
+template<typename Weight>
+class TreeCacheRouter {
+ private:
+  using Graph = DirectedWeightedGraph<Weight>;
+  using Tree = ShortestPathTree<Weight>;
+
+ public:
+  // Time: O(V+E), Mem: O(V+E). `capacity` must be positive.
+  explicit TreeCacheRouter(const Graph &graph, size_t capacity = 16);
+
+  // Returns the weight of the route and replaces the content of `edges` with
+  // its edges. May be called concurrently.
+  // Time: O(R) on a hit, O((V+E)logV) on a miss, Mem: O(V*capacity),
+  // R - size of the route.
+  std::optional<Weight> BuildRoute(VertexId from,
+                                   VertexId to,
+                                   std::vector<EdgeId> &edges) const;
+
+  // The tree rooted at `root`, built on a miss. It stays valid after it is
+  // evicted. Counts as a query.
+  std::shared_ptr<const Tree> GetTree(VertexId root) const;
+
+  size_t GetHitCount() const;
+  size_t GetMissCount() const;
+
+ private:
+  using Entry = std::pair<VertexId, std::shared_ptr<const Tree>>;
+
+  const CsrGraph<Weight> graph_;
+  const size_t capacity_;
+
+  // Guards the cache and the counters, but not the search on a miss.
+  mutable std::mutex mutex_;
+  // Most recently used first.
+  mutable std::list<Entry> trees_;
+  mutable std::unordered_map<VertexId,
+                             typename std::list<Entry>::iterator> positions_;
+  mutable size_t hit_count_ = 0;
+  mutable size_t miss_count_ = 0;
+};
+
+template<typename Weight>
+TreeCacheRouter<Weight>::TreeCacheRouter(const Graph &graph, size_t capacity)
+    : graph_(graph), capacity_(capacity) {
+  assert(capacity > 0);
+}
+
+template<typename Weight>
+std::optional<Weight> TreeCacheRouter<Weight>::BuildRoute(
+    VertexId from,
+    VertexId to,
+    std::vector<EdgeId> &edges) const {
+  const auto tree = GetTree(from);
+  tree->GetRoute(to, edges);
+  return tree->GetWeight(to);
+}
+
+template<typename Weight>
+std::shared_ptr<const typename TreeCacheRouter<Weight>::Tree>
+TreeCacheRouter<Weight>::GetTree(VertexId root) const {
+  {
+    std::lock_guard lock(mutex_);
+    if (auto it = positions_.find(root); it != positions_.end()) {
+      ++hit_count_;
+      trees_.splice(trees_.begin(), trees_, it->second);
+      return it->second->second;
+    }
+    ++miss_count_;
+  }
+
+  // Other threads keep querying the cache while the tree is searched.
+  auto tree = std::make_shared<Tree>(graph_);
+  tree->Build(root);
+
+  std::lock_guard lock(mutex_);
+  // Another thread may have added the same tree meanwhile.
+  if (auto it = positions_.find(root); it != positions_.end()) {
+    trees_.splice(trees_.begin(), trees_, it->second);
+    return it->second->second;
+  }
+  if (trees_.size() == capacity_) {
+    positions_.erase(trees_.back().first);
+    trees_.pop_back();
+  }
+  trees_.emplace_front(root, std::move(tree));
+  positions_[root] = trees_.begin();
+  return trees_.front().second;
+}
+
+template<typename Weight>
+size_t TreeCacheRouter<Weight>::GetHitCount() const {
+  std::lock_guard lock(mutex_);
+  return hit_count_;
+}
+
+template<typename Weight>
+size_t TreeCacheRouter<Weight>::GetMissCount() const {
+  std::lock_guard lock(mutex_);
+  return miss_count_;
+}
+}
+
+#endif // GRAPH_TREE_CACHE_ROUTER_H_
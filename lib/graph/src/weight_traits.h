@@ -0,0 +1,100 @@
+#ifndef GRAPH_WEIGHT_TRAITS_H_
+#define GRAPH_WEIGHT_TRAITS_H_
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace graph {
+// How the all-pairs precomputation treats a weight type: kInfinity marks a
+// missing route, and Add sums two weights. When kAbsorbsInfinity is set, Add
+// returns kInfinity whenever an argument is kInfinity, so callers need no
+// separate check for it.
+template<typename Weight>
+struct WeightTraits {
+  static constexpr bool kAbsorbsInfinity =
+      std::numeric_limits<Weight>::has_infinity;
+  static constexpr Weight kInfinity =
+      std::numeric_limits<Weight>::has_infinity
+      ? std::numeric_limits<Weight>::infinity()
+      : std::numeric_limits<Weight>::max();
+
+  static constexpr Weight Add(Weight lhs, Weight rhs) { return lhs + rhs; }
+};
+
+// Non-negative weight counted in 1/Scale units in an unsigned integer, e.g.
+// FixedPoint<uint32_t, 1000> holds thousandths of a minute up to about 8
+// years. Integer sums and comparisons are exact and cheaper than floating
+// ones, and the conversion from a real weight rounds it to the nearest unit.
+template<typename Rep, Rep Scale>
+class FixedPoint {
+  static_assert(std::is_unsigned_v<Rep>);
+
+ public:
+  constexpr FixedPoint() = default;
+  // `value` must be non-negative and below the largest representable weight.
+  explicit FixedPoint(double value)
+      : units_(static_cast<Rep>(std::llround(value * Scale))) {
+    assert(value >= 0 &&
+           value * Scale < std::numeric_limits<Rep>::max());
+  }
+
+  static constexpr FixedPoint FromUnits(Rep units) {
+    FixedPoint weight;
+    weight.units_ = units;
+    return weight;
+  }
+
+  constexpr Rep GetUnits() const { return units_; }
+  explicit constexpr operator double() const {
+    return static_cast<double>(units_) / Scale;
+  }
+
+  // Wraps around on overflow, see WeightTraits for the saturating sum.
+  friend constexpr FixedPoint operator+(FixedPoint lhs, FixedPoint rhs) {
+    return FromUnits(lhs.units_ + rhs.units_);
+  }
+  FixedPoint &operator+=(FixedPoint rhs) {
+    units_ += rhs.units_;
+    return *this;
+  }
+
+  friend constexpr bool operator==(FixedPoint lhs, FixedPoint rhs) {
+    return lhs.units_ == rhs.units_;
+  }
+  friend constexpr bool operator!=(FixedPoint lhs, FixedPoint rhs) {
+    return lhs.units_ != rhs.units_;
+  }
+  friend constexpr bool operator<(FixedPoint lhs, FixedPoint rhs) {
+    return lhs.units_ < rhs.units_;
+  }
+  friend constexpr bool operator>(FixedPoint lhs, FixedPoint rhs) {
+    return lhs.units_ > rhs.units_;
+  }
+
+ private:
+  Rep units_ = 0;
+};
+
+// The largest value is the infinity, and sums saturate to it, so overflowing
+// routes read as missing rather than wrapping around to short ones.
+template<typename Rep, Rep Scale>
+struct WeightTraits<FixedPoint<Rep, Scale>> {
+  static constexpr bool kAbsorbsInfinity = true;
+  static constexpr FixedPoint<Rep, Scale> kInfinity =
+      FixedPoint<Rep, Scale>::FromUnits(std::numeric_limits<Rep>::max());
+
+  static constexpr FixedPoint<Rep, Scale> Add(FixedPoint<Rep, Scale> lhs,
+                                              FixedPoint<Rep, Scale> rhs) {
+    const Rep units = lhs.GetUnits() + rhs.GetUnits();
+    // Unsigned sums wrap below either argument, which the mask turns into
+    // all ones without a branch.
+    return FixedPoint<Rep, Scale>::FromUnits(
+        units | -static_cast<Rep>(units < lhs.GetUnits()));
+  }
+};
+}
+
+#endif // GRAPH_WEIGHT_TRAITS_H_
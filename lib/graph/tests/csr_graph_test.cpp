@@ -0,0 +1,97 @@
+#include "csr_graph.h"
+
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "graph.h"
+
+namespace {
+struct Arc {
+  graph::VertexId to;
+  int weight;
+  graph::EdgeId edge_id;
+
+  bool operator==(const Arc &other) const {
+    return to == other.to && weight == other.weight &&
+        edge_id == other.edge_id;
+  }
+};
+}
+
+TEST(TestCsrGraph, TestOutgoingArcs) {
+  graph::DirectedWeightedGraph<int> graph(4);
+  graph.AddEdge({2, 0, 7});
+  graph.AddEdge({0, 1, 10});
+  graph.AddEdge({2, 2, 1});
+  graph.AddEdge({0, 3, 25});
+  const graph::CsrGraph<int> csr_graph(graph, true);
+
+  struct TestCase {
+    std::string name;
+    graph::VertexId vertex;
+    std::vector<Arc> want;
+    std::vector<Arc> want_incoming;
+  };
+
+  std::vector<TestCase> test_cases{
+      TestCase{
+          .name = "Arcs keep the order of the edges",
+          .vertex = 0,
+          .want = {{1, 10, 1}, {3, 25, 3}},
+          .want_incoming = {{2, 7, 0}},
+      },
+      TestCase{
+          .name = "No outgoing edges",
+          .vertex = 1,
+          .want = {},
+          .want_incoming = {{0, 10, 1}},
+      },
+      TestCase{
+          .name = "Loop",
+          .vertex = 2,
+          .want = {{0, 7, 0}, {2, 1, 2}},
+          .want_incoming = {{2, 1, 2}},
+      },
+      TestCase{
+          .name = "Last vertex",
+          .vertex = 3,
+          .want = {},
+          .want_incoming = {{0, 25, 3}},
+      },
+  };
+
+  EXPECT_EQ(4, csr_graph.GetVertexCount());
+  EXPECT_EQ(4, csr_graph.GetEdgeCount());
+  for (auto &[name, vertex, want, want_incoming] : test_cases) {
+    std::vector<Arc> got;
+    for (auto &arc : csr_graph.GetOutgoingArcs(vertex)) {
+      got.push_back({arc.to, arc.weight, arc.edge_id});
+      auto &edge = csr_graph.GetEdge(arc.edge_id);
+      EXPECT_EQ(vertex, edge.from) << name;
+      EXPECT_EQ(arc.to, edge.to) << name;
+    }
+    EXPECT_EQ(want, got) << name;
+
+    std::vector<Arc> got_incoming;
+    for (auto &arc : csr_graph.GetIncomingArcs(vertex)) {
+      got_incoming.push_back({arc.to, arc.weight, arc.edge_id});
+      auto &edge = csr_graph.GetEdge(arc.edge_id);
+      EXPECT_EQ(arc.to, edge.from) << name;
+      EXPECT_EQ(vertex, edge.to) << name;
+    }
+    EXPECT_EQ(want_incoming, got_incoming) << name;
+  }
+}
+
+TEST(TestCsrGraph, TestNoIncomingArcs) {
+  graph::DirectedWeightedGraph<int> graph(2);
+  graph.AddEdge({0, 1, 10});
+  const graph::CsrGraph<int> csr_graph(graph);
+  EXPECT_EQ(1, std::distance(csr_graph.GetOutgoingArcs(0).begin(),
+                             csr_graph.GetOutgoingArcs(0).end()));
+  EXPECT_EQ(csr_graph.GetIncomingArcs(1).begin(),
+            csr_graph.GetIncomingArcs(1).end());
+}
@@ -0,0 +1,138 @@
+#include "min_plus.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "graph.h"
+#include "weight_traits.h"
+
+namespace {
+using FixedPoint = graph::FixedPoint<uint32_t, 1000>;
+
+template<typename Weight, typename EdgeIdType>
+struct Row {
+  std::vector<Weight> weights;
+  std::vector<EdgeIdType> prev_edges;
+};
+
+template<typename Weight, typename EdgeIdType>
+Row<Weight, EdgeIdType> RandomRow(size_t size, std::mt19937 &gen) {
+  std::uniform_real_distribution<double> weight(0.0, 100.0);
+  std::bernoulli_distribution missing(0.2);
+
+  Row<Weight, EdgeIdType> row;
+  for (size_t i = 0; i < size; ++i) {
+    row.weights.push_back(missing(gen) ? graph::min_plus::kNoWeight<Weight>
+                                       : static_cast<Weight>(weight(gen)));
+    row.prev_edges.push_back(gen());
+  }
+  return row;
+}
+
+template<typename Weight, typename EdgeIdType, typename Kernel>
+void ExpectSameAsScalar(Kernel kernel) {
+  std::mt19937 gen(42);
+  // Sizes not divisible by the vector width exercise the scalar tails.
+  for (size_t size : {0, 1, 3, 4, 7, 8, 13, 64, 101}) {
+    for (double weight : {0.0, 12.5, 70.0}) {
+      const auto weight_from = static_cast<Weight>(weight);
+      const auto through = RandomRow<Weight, EdgeIdType>(size, gen);
+      auto want = RandomRow<Weight, EdgeIdType>(size, gen);
+      auto got = want;
+
+      graph::min_plus::RelaxRowScalar(
+          weight_from, through.weights.data(), through.prev_edges.data(),
+          want.weights.data(), want.prev_edges.data(), size);
+      kernel(weight_from, through.weights.data(), through.prev_edges.data(),
+             got.weights.data(), got.prev_edges.data(), size);
+
+      EXPECT_EQ(want.weights, got.weights) << size;
+      EXPECT_EQ(want.prev_edges, got.prev_edges) << size;
+    }
+  }
+}
+}
+
+TEST(TestMinPlus, TestRelaxRowScalar) {
+  const double kNo = graph::min_plus::kNoWeight<double>;
+  std::vector<double> through = {1, kNo, 2, 0};
+  std::vector<graph::EdgeId> through_edges = {10, 11, 12, 13};
+  std::vector<double> from = {kNo, 5, 4, 3};
+  std::vector<graph::EdgeId> from_edges = {20, 21, 22, 23};
+
+  graph::min_plus::RelaxRowScalar(2.0, through.data(), through_edges.data(),
+                                  from.data(), from_edges.data(), 4);
+
+  EXPECT_EQ(from, (std::vector<double>{3, 5, 4, 2}));
+  EXPECT_EQ(from_edges, (std::vector<graph::EdgeId>{10, 21, 22, 13}));
+}
+
+TEST(TestMinPlus, TestRelaxRowScalarWithoutInfinity) {
+  const int kNo = graph::min_plus::kNoWeight<int>;
+  std::vector<int> through = {kNo, 1};
+  std::vector<uint32_t> through_edges = {10, 11};
+  std::vector<int> from = {kNo, kNo};
+  std::vector<uint32_t> from_edges = {20, 21};
+
+  graph::min_plus::RelaxRowScalar(5, through.data(), through_edges.data(),
+                                  from.data(), from_edges.data(), 2);
+
+  EXPECT_EQ(from, (std::vector<int>{kNo, 6}));
+  EXPECT_EQ(from_edges, (std::vector<uint32_t>{20, 11}));
+}
+
+TEST(TestMinPlus, TestRelaxRowScalarFixedPoint) {
+  // Sums past the largest weight saturate to the infinity, not wrap around.
+  const FixedPoint kNo = graph::min_plus::kNoWeight<FixedPoint>;
+  const auto big = FixedPoint::FromUnits(kNo.GetUnits() - 10);
+  std::vector<FixedPoint> through = {kNo, big, FixedPoint(1.5)};
+  std::vector<uint32_t> through_edges = {10, 11, 12};
+  std::vector<FixedPoint> from = {kNo, kNo, kNo};
+  std::vector<uint32_t> from_edges = {20, 21, 22};
+
+  graph::min_plus::RelaxRowScalar(FixedPoint(0.5), through.data(),
+                                  through_edges.data(), from.data(),
+                                  from_edges.data(), 3);
+
+  EXPECT_EQ(from, (std::vector<FixedPoint>{kNo, kNo, FixedPoint(2.0)}));
+  EXPECT_EQ(from_edges, (std::vector<uint32_t>{20, 21, 12}));
+}
+
+TEST(TestMinPlus, TestDispatchedKernel) {
+  auto kernel = [](auto... args) {
+    graph::min_plus::RelaxRow(args...);
+  };
+  ExpectSameAsScalar<double, graph::EdgeId>(kernel);
+  ExpectSameAsScalar<float, uint32_t>(kernel);
+  ExpectSameAsScalar<FixedPoint, uint32_t>(kernel);
+}
+
+#if GRAPH_MIN_PLUS_X86
+TEST(TestMinPlus, TestSse41Kernel) {
+  if (graph::min_plus::DetectKernel() < graph::min_plus::Kernel::kSse41) {
+    GTEST_SKIP() << "SSE4.1 isn't supported";
+  }
+  auto kernel = [](auto... args) {
+    graph::min_plus::RelaxRowSse41(args...);
+  };
+  ExpectSameAsScalar<double, graph::EdgeId>(kernel);
+  ExpectSameAsScalar<float, uint32_t>(kernel);
+  ExpectSameAsScalar<FixedPoint, uint32_t>(kernel);
+}
+
+TEST(TestMinPlus, TestAvx2Kernel) {
+  if (graph::min_plus::DetectKernel() < graph::min_plus::Kernel::kAvx2) {
+    GTEST_SKIP() << "AVX2 isn't supported";
+  }
+  auto kernel = [](auto... args) {
+    graph::min_plus::RelaxRowAvx2(args...);
+  };
+  ExpectSameAsScalar<double, graph::EdgeId>(kernel);
+  ExpectSameAsScalar<float, uint32_t>(kernel);
+  ExpectSameAsScalar<FixedPoint, uint32_t>(kernel);
+}
+#endif
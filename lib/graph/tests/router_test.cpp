@@ -0,0 +1,730 @@
+#include "router.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "a_star_router.h"
+#include "bidirectional_dijkstra_router.h"
+#include "contraction_hierarchy_router.h"
+#include "csr_graph.h"
+#include "dijkstra_router.h"
+#include "graph.h"
+#include "hub_label_router.h"
+#include "overlay_router.h"
+#include "shortest_path_tree.h"
+#include "tree_cache_router.h"
+#include "weight_traits.h"
+
+namespace {
+struct Route {
+  int weight;
+  std::vector<graph::EdgeId> edges;
+};
+
+graph::DirectedWeightedGraph<int> RandomGraph(size_t vertex_count,
+                                              size_t edge_count,
+                                              unsigned seed) {
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<graph::VertexId> vertex(0, vertex_count - 1);
+  std::uniform_int_distribution<int> weight(0, 100);
+
+  graph::DirectedWeightedGraph<int> graph(vertex_count);
+  for (size_t i = 0; i < edge_count; ++i) {
+    graph.AddEdge({vertex(gen), vertex(gen), weight(gen)});
+  }
+  return graph;
+}
+
+graph::DirectedWeightedGraph<double> RandomRealGraph(size_t vertex_count,
+                                                     size_t edge_count,
+                                                     unsigned seed) {
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<graph::VertexId> vertex(0, vertex_count - 1);
+  std::uniform_real_distribution<double> weight(0.1, 20.0);
+
+  graph::DirectedWeightedGraph<double> graph(vertex_count);
+  for (size_t i = 0; i < edge_count; ++i) {
+    graph.AddEdge({vertex(gen), vertex(gen), weight(gen)});
+  }
+  return graph;
+}
+
+// Road-like side*side grid, each pair of neighbors linked both ways with
+// weights from 1 to 10.
+graph::DirectedWeightedGraph<int> GridGraph(size_t side, unsigned seed) {
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<int> weight(1, 10);
+
+  graph::DirectedWeightedGraph<int> graph(side * side);
+  for (graph::VertexId vertex = 0; vertex < side * side; ++vertex) {
+    if (vertex % side + 1 < side) {
+      graph.AddEdge({vertex, vertex + 1, weight(gen)});
+      graph.AddEdge({vertex + 1, vertex, weight(gen)});
+    }
+    if (vertex + side < side * side) {
+      graph.AddEdge({vertex, vertex + side, weight(gen)});
+      graph.AddEdge({vertex + side, vertex, weight(gen)});
+    }
+  }
+  return graph;
+}
+
+template<typename Router>
+std::optional<Route> FindRoute(const Router &router,
+                               graph::VertexId from,
+                               graph::VertexId to) {
+  Route route;
+  auto weight = router.BuildRoute(from, to, route.edges);
+  if (!weight) return std::nullopt;
+
+  route.weight = *weight;
+  return route;
+}
+
+// Checks that the route is a chain of edges from `from` to `to` with the
+// declared total weight.
+void ExpectValidRoute(const graph::DirectedWeightedGraph<int> &graph,
+                      const Route &route,
+                      graph::VertexId from,
+                      graph::VertexId to,
+                      const std::string &name) {
+  graph::VertexId vertex = from;
+  int weight = 0;
+  for (auto edge_id : route.edges) {
+    auto &edge = graph.GetEdge(edge_id);
+    EXPECT_EQ(vertex, edge.from) << name;
+    vertex = edge.to;
+    weight += edge.weight;
+  }
+  EXPECT_EQ(to, vertex) << name;
+  EXPECT_EQ(route.weight, weight) << name;
+}
+
+template<typename ExpectedRouter, typename Router>
+void ExpectSameRoutes(const graph::DirectedWeightedGraph<int> &graph,
+                      const ExpectedRouter &expected_router,
+                      const Router &router,
+                      const std::string &name) {
+  const size_t vertex_count = graph.GetVertexCount();
+  for (graph::VertexId from = 0; from < vertex_count; ++from) {
+    for (graph::VertexId to = 0; to < vertex_count; ++to) {
+      auto want = FindRoute(expected_router, from, to);
+      auto got = FindRoute(router, from, to);
+
+      EXPECT_EQ(want.has_value(), got.has_value()) << name;
+      if (!want || !got) continue;
+
+      EXPECT_EQ(want->weight, got->weight) << name;
+      ExpectValidRoute(graph, *got, from, to, name);
+    }
+  }
+}
+
+template<typename ExpectedRouter, typename Router>
+void CompareRouters(const graph::DirectedWeightedGraph<int> &graph,
+                    const std::string &name) {
+  ExpectSameRoutes(graph, ExpectedRouter(graph), Router(graph), name);
+}
+}
+
+TEST(TestRouter, TestBuildRoute) {
+  graph::DirectedWeightedGraph<int> graph(5);
+  graph.AddEdge({0, 1, 10});
+  graph.AddEdge({1, 2, 10});
+  graph.AddEdge({0, 2, 25});
+  graph.AddEdge({2, 3, 1});
+  graph.AddEdge({3, 2, 1});
+
+  struct TestCase {
+    std::string name;
+    graph::VertexId from;
+    graph::VertexId to;
+    std::optional<Route> want;
+  };
+
+  std::vector<TestCase> test_cases{
+      TestCase{
+          .name = "Same vertex",
+          .from = 1, .to = 1,
+          .want = Route{.weight = 0, .edges = {}},
+      },
+      TestCase{
+          .name = "Shorter path through intermediate vertex",
+          .from = 0, .to = 3,
+          .want = Route{.weight = 21, .edges = {0, 1, 3}},
+      },
+      TestCase{
+          .name = "Path against edge direction",
+          .from = 2, .to = 0,
+          .want = std::nullopt,
+      },
+      TestCase{
+          .name = "Isolated vertex",
+          .from = 0, .to = 4,
+          .want = std::nullopt,
+      },
+  };
+
+  graph::Router<int> floyd_warshall(graph);
+  graph::DijkstraRouter<int> dijkstra(graph);
+  graph::ContractionHierarchyRouter<int> contraction_hierarchy(graph);
+  graph::BidirectionalDijkstraRouter<int> bidirectional_dijkstra(graph);
+  graph::HubLabelRouter<int> hub_labels(graph);
+  graph::TreeCacheRouter<int> tree_cache(graph);
+  graph::OverlayRouter<int> overlay(graph, {2, 4});
+  for (auto &[name, from, to, want] : test_cases) {
+    for (auto got : {FindRoute(floyd_warshall, from, to),
+                     FindRoute(dijkstra, from, to),
+                     FindRoute(contraction_hierarchy, from, to),
+                     FindRoute(bidirectional_dijkstra, from, to),
+                     FindRoute(hub_labels, from, to),
+                     FindRoute(tree_cache, from, to),
+                     FindRoute(overlay, from, to)}) {
+      EXPECT_EQ(want.has_value(), got.has_value()) << name;
+      if (!want || !got) continue;
+
+      EXPECT_EQ(want->weight, got->weight) << name;
+      EXPECT_EQ(want->edges, got->edges) << name;
+    }
+  }
+}
+
+TEST(TestRouter, TestRandomGraphs) {
+  // Spans several tiles of the blocked Floyd-Warshall, the last one partial.
+  for (unsigned seed = 0; seed < 3; ++seed) {
+    CompareRouters<graph::DijkstraRouter<int>, graph::Router<int>>(
+        RandomGraph(150, 600, seed), "Seed " + std::to_string(seed));
+  }
+}
+
+TEST(TestRouter, TestComponents) {
+  // Clusters of 10 to 40 vertices with edges only inside them, interleaved
+  // in the vertex order, plus isolated vertices at the end.
+  std::mt19937 gen(3);
+  const size_t cluster_count = 6;
+  std::uniform_int_distribution<size_t> cluster_size(10, 40);
+  std::vector<std::vector<graph::VertexId>> clusters(cluster_count);
+  size_t vertex_count = 0;
+  for (auto &cluster : clusters) {
+    cluster.resize(cluster_size(gen));
+    vertex_count += cluster.size();
+  }
+  for (graph::VertexId vertex = 0, idx = 0; vertex < vertex_count; ++idx) {
+    for (auto &cluster : clusters) {
+      if (idx < cluster.size()) cluster[idx] = vertex++;
+    }
+  }
+
+  graph::DirectedWeightedGraph<int> graph(vertex_count + 5);
+  std::uniform_int_distribution<int> weight(0, 100);
+  size_t want_cell_count = 5;
+  for (auto &cluster : clusters) {
+    std::uniform_int_distribution<size_t> idx(0, cluster.size() - 1);
+    // A chain keeps the cluster connected, the rest adds shortcuts.
+    for (size_t i = 1; i < cluster.size(); ++i) {
+      graph.AddEdge({cluster[i - 1], cluster[i], weight(gen)});
+    }
+    for (size_t i = 0; i < cluster.size() * 3; ++i) {
+      graph.AddEdge({cluster[idx(gen)], cluster[idx(gen)], weight(gen)});
+    }
+    want_cell_count += cluster.size() * cluster.size();
+  }
+
+  graph::Router<int> router(graph);
+  EXPECT_EQ(cluster_count + 5, router.GetComponentCount());
+  EXPECT_EQ(want_cell_count, router.GetCellCount());
+  CompareRouters<graph::DijkstraRouter<int>, graph::Router<int>>(
+      graph, "Clusters");
+  CompareRouters<graph::DijkstraRouter<int>, graph::CompactRouter<int>>(
+      graph, "Compact clusters");
+}
+
+TEST(TestRouter, TestUpdateEdge) {
+  // Starts from scattered components, which the added edges join.
+  const size_t vertex_count = 80;
+  auto graph = RandomGraph(vertex_count, 40, 11);
+  graph::Router<int> router(graph);
+  const size_t initial_component_count = router.GetComponentCount();
+
+  std::mt19937 gen(5);
+  std::uniform_int_distribution<graph::VertexId> vertex(0, vertex_count - 1);
+  std::uniform_int_distribution<int> weight(0, 100);
+  for (int step = 0; step < 60; ++step) {
+    const std::string name = "Step " + std::to_string(step);
+    if (step % 3 == 2) {
+      std::uniform_int_distribution<graph::EdgeId> edge(
+          0, graph.GetEdgeCount() - 1);
+      const graph::EdgeId edge_id = edge(gen);
+      graph.SetEdgeWeight(edge_id, graph.GetEdge(edge_id).weight / 2);
+      router.UpdateEdge(edge_id);
+    } else {
+      router.UpdateEdge(graph.AddEdge({vertex(gen), vertex(gen), weight(gen)}));
+    }
+
+    const graph::DijkstraRouter<int> dijkstra(graph);
+    for (graph::VertexId from = 0; from < vertex_count; ++from) {
+      for (graph::VertexId to = 0; to < vertex_count; ++to) {
+        auto want = FindRoute(dijkstra, from, to);
+        auto got = FindRoute(router, from, to);
+        ASSERT_EQ(want.has_value(), got.has_value()) << name;
+        if (!want) continue;
+        EXPECT_EQ(want->weight, got->weight) << name;
+        ExpectValidRoute(graph, *got, from, to, name);
+      }
+    }
+  }
+  EXPECT_LT(router.GetComponentCount(), initial_component_count);
+
+  // A weight increase falls back to a rebuild.
+  graph.SetEdgeWeight(0, graph.GetEdge(0).weight + 50);
+  router.Rebuild();
+  CompareRouters<graph::DijkstraRouter<int>, graph::Router<int>>(
+      graph, "Rebuilt");
+}
+
+TEST(TestRouter, TestUpdateExternalTables) {
+  auto graph = RandomGraph(50, 100, 2);
+  const graph::Router<int> router(graph);
+  const std::vector<int> weights(
+      router.GetWeights(), router.GetWeights() + router.GetCellCount());
+  const std::vector<graph::EdgeId> prev_edges(
+      router.GetPrevEdges(), router.GetPrevEdges() + router.GetCellCount());
+
+  graph::Router<int> wrapped(graph, weights.data(), prev_edges.data());
+  wrapped.UpdateEdge(graph.AddEdge({0, 49, 1}));
+  // The update works on a copy, the external tables stay the same.
+  EXPECT_TRUE(std::equal(weights.begin(), weights.end(),
+                         router.GetWeights()));
+  const graph::DijkstraRouter<int> dijkstra(graph);
+  for (graph::VertexId from = 0; from < 50; ++from) {
+    for (graph::VertexId to = 0; to < 50; ++to) {
+      auto want = FindRoute(dijkstra, from, to);
+      auto got = FindRoute(wrapped, from, to);
+      ASSERT_EQ(want.has_value(), got.has_value());
+      if (!want) continue;
+      EXPECT_EQ(want->weight, got->weight);
+      ExpectValidRoute(graph, *got, from, to, "External");
+    }
+  }
+}
+
+TEST(TestDijkstraRouter, TestRandomGraphs) {
+  for (unsigned seed = 0; seed < 10; ++seed) {
+    CompareRouters<graph::Router<int>, graph::DijkstraRouter<int>>(
+        RandomGraph(40, 120, seed), "Seed " + std::to_string(seed));
+  }
+}
+
+TEST(TestContractionHierarchyRouter, TestRandomGraphs) {
+  for (unsigned seed = 0; seed < 10; ++seed) {
+    CompareRouters<graph::DijkstraRouter<int>,
+                   graph::ContractionHierarchyRouter<int>>(
+        RandomGraph(60, 200, seed), "Seed " + std::to_string(seed));
+  }
+}
+
+TEST(TestContractionHierarchyRouter, TestGridGraph) {
+  // Road-like graph, where contraction keeps the shortcut count low.
+  const size_t side = 12;
+  const auto graph = GridGraph(side, 7);
+
+  graph::ContractionHierarchyRouter<int> router(graph);
+  EXPECT_LT(router.GetShortcutCount(), graph.GetEdgeCount() * 2);
+  CompareRouters<graph::DijkstraRouter<int>,
+                 graph::ContractionHierarchyRouter<int>>(graph, "Grid");
+}
+
+TEST(TestAStarRouter, TestGridGraph) {
+  // Every step weighs at least 1, so the Manhattan distance is a consistent
+  // lower bound.
+  const size_t side = 12;
+  const auto graph = GridGraph(side, 7);
+  auto manhattan = [side](graph::VertexId from, graph::VertexId to) {
+    const int dx = static_cast<int>(from % side) - static_cast<int>(to % side);
+    const int dy = static_cast<int>(from / side) - static_cast<int>(to / side);
+    return std::abs(dx) + std::abs(dy);
+  };
+
+  const graph::DijkstraRouter<int> dijkstra(graph);
+  const graph::AStarRouter<int, decltype(manhattan)> a_star(graph, manhattan);
+  size_t dijkstra_settled_total = 0, a_star_settled_total = 0;
+  std::vector<graph::EdgeId> want_edges, got_edges;
+  for (graph::VertexId from = 0; from < side * side; ++from) {
+    for (graph::VertexId to = 0; to < side * side; ++to) {
+      size_t dijkstra_settled, a_star_settled;
+      auto want = dijkstra.BuildRoute(from, to, want_edges, &dijkstra_settled);
+      auto got = a_star.BuildRoute(from, to, got_edges, &a_star_settled);
+      dijkstra_settled_total += dijkstra_settled;
+      a_star_settled_total += a_star_settled;
+
+      ASSERT_TRUE(want && got);
+      EXPECT_EQ(*want, *got);
+      ExpectValidRoute(graph, Route{*got, got_edges}, from, to, "Grid");
+      EXPECT_LE(a_star_settled, dijkstra_settled);
+    }
+  }
+  EXPECT_LT(a_star_settled_total, dijkstra_settled_total);
+}
+
+TEST(TestBidirectionalDijkstraRouter, TestRandomGraphs) {
+  for (unsigned seed = 0; seed < 5; ++seed) {
+    CompareRouters<graph::Router<int>, graph::BidirectionalDijkstraRouter<int>>(
+        RandomGraph(60, 200, seed), "Seed " + std::to_string(seed));
+  }
+}
+
+TEST(TestBidirectionalDijkstraRouter, TestSettledCount) {
+  // Away from the borders of a grid, a search settles a disk around its
+  // start, so two searches of half the radius settle about half as much.
+  const size_t side = 60;
+  const auto graph = GridGraph(side, 7);
+
+  const graph::DijkstraRouter<int> dijkstra(graph);
+  const graph::BidirectionalDijkstraRouter<int> bidirectional(graph);
+  const graph::VertexId from = side * side / 2 + 20;
+  const graph::VertexId to = side * side / 2 + 40;
+  std::vector<graph::EdgeId> want_edges, got_edges;
+  size_t dijkstra_settled, bidirectional_settled;
+  auto want = dijkstra.BuildRoute(from, to, want_edges, &dijkstra_settled);
+  auto got = bidirectional.BuildRoute(from, to, got_edges,
+                                      &bidirectional_settled);
+  ASSERT_TRUE(want && got);
+  EXPECT_EQ(*want, *got);
+  ExpectValidRoute(graph, Route{*got, got_edges}, from, to, "Grid");
+  EXPECT_LT(bidirectional_settled * 3, dijkstra_settled * 2);
+}
+
+TEST(TestHubLabelRouter, TestRandomGraphs) {
+  for (unsigned seed = 0; seed < 10; ++seed) {
+    CompareRouters<graph::DijkstraRouter<int>, graph::HubLabelRouter<int>>(
+        RandomGraph(60, 200, seed), "Seed " + std::to_string(seed));
+  }
+}
+
+TEST(TestHubLabelRouter, TestGridGraph) {
+  // Pruning keeps the labels far below the V^2 entries of a full table.
+  const size_t side = 12;
+  const auto graph = GridGraph(side, 7);
+
+  graph::HubLabelRouter<int> router(graph);
+  EXPECT_LT(router.GetLabelEntryCount(), side * side * side * side / 2);
+  CompareRouters<graph::DijkstraRouter<int>, graph::HubLabelRouter<int>>(
+      graph, "Grid");
+}
+
+TEST(TestOverlayRouter, TestRandomGraphs) {
+  // Small cells, so that most routes cross several of them.
+  const std::vector<std::vector<size_t>> cell_sizes{
+      {1}, {8}, {4, 16}, {2, 6, 20}};
+  for (unsigned seed = 0; seed < 5; ++seed) {
+    const auto graph = RandomGraph(60, 200, seed);
+    const std::string name = "Seed " + std::to_string(seed);
+    const graph::DijkstraRouter<int> dijkstra(graph);
+    for (const auto &sizes : cell_sizes) {
+      ExpectSameRoutes(graph, dijkstra,
+                       graph::OverlayRouter<int>(graph, sizes), name);
+    }
+  }
+}
+
+TEST(TestOverlayRouter, TestCustomize) {
+  auto graph = RandomGraph(80, 300, 4);
+  graph::OverlayRouter<int> overlay(graph, {5, 20}, 3);
+  ASSERT_EQ(overlay.GetLevelCount(), 2);
+  EXPECT_GE(overlay.GetCellCount(0), 16);
+  EXPECT_GE(overlay.GetCellCount(1), 4);
+
+  // New weights need new cliques, but no new cells.
+  std::mt19937 gen(9);
+  std::uniform_int_distribution<int> weight(0, 100);
+  for (graph::EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+    graph.SetEdgeWeight(edge_id, weight(gen));
+  }
+  overlay.Customize(3);
+  ExpectSameRoutes(graph, graph::DijkstraRouter<int>(graph), overlay,
+                   "Customized");
+}
+
+TEST(TestRouter, TestParallelPrecomputation) {
+  // Real-valued weights expose any change in the order of additions.
+  const auto graph = RandomRealGraph(200, 1000, 42);
+
+  graph::Router<double> serial(graph);
+  for (size_t thread_count : {2, 3, 8}) {
+    graph::Router<double> parallel(graph, thread_count);
+    for (graph::VertexId from = 0; from < 200; ++from) {
+      for (graph::VertexId to = 0; to < 200; ++to) {
+        std::vector<graph::EdgeId> want_edges, got_edges;
+        auto want = serial.BuildRoute(from, to, want_edges);
+        auto got = parallel.BuildRoute(from, to, got_edges);
+        EXPECT_EQ(want, got);
+        EXPECT_EQ(want_edges, got_edges);
+      }
+    }
+  }
+}
+
+TEST(TestCompactRouter, TestRandomGraphs) {
+  // Small integer weights are exact in float, so the routes must be optimal.
+  for (unsigned seed = 0; seed < 3; ++seed) {
+    CompareRouters<graph::DijkstraRouter<int>, graph::CompactRouter<int>>(
+        RandomGraph(150, 600, seed), "Seed " + std::to_string(seed));
+  }
+}
+
+TEST(TestCompactRouter, TestRealWeights) {
+  const auto graph = RandomRealGraph(200, 1000, 42);
+
+  graph::Router<double> router(graph);
+  graph::CompactRouter<double> compact(graph);
+  for (graph::VertexId from = 0; from < 200; ++from) {
+    for (graph::VertexId to = 0; to < 200; ++to) {
+      std::vector<graph::EdgeId> want_edges, got_edges;
+      auto want = router.BuildRoute(from, to, want_edges);
+      auto got = compact.BuildRoute(from, to, got_edges);
+      EXPECT_EQ(want, router.GetWeight(from, to));
+      ASSERT_EQ(want.has_value(), got.has_value());
+      if (!want) continue;
+      EXPECT_DOUBLE_EQ(*got, *compact.GetWeight(from, to));
+
+      // The weight is summed from the route edges, so it is exact for the
+      // route found, which is at most float rounding longer than optimal.
+      double weight = 0;
+      graph::VertexId vertex = from;
+      for (auto edge_id : got_edges) {
+        auto &edge = graph.GetEdge(edge_id);
+        EXPECT_EQ(vertex, edge.from);
+        vertex = edge.to;
+        weight += edge.weight;
+      }
+      EXPECT_EQ(to, vertex);
+      EXPECT_EQ(weight, *got);
+      EXPECT_NEAR(*want, *got, *want * 1e-5);
+    }
+  }
+}
+
+TEST(TestFixedPointRouter, TestRandomGraphs) {
+  // Integer weights are exact in thousandths, so the routes must be optimal.
+  for (unsigned seed = 0; seed < 3; ++seed) {
+    CompareRouters<graph::DijkstraRouter<int>, graph::FixedPointRouter<int>>(
+        RandomGraph(150, 600, seed), "Seed " + std::to_string(seed));
+  }
+}
+
+TEST(TestFixedPointRouter, TestFixedPointWeights) {
+  // The same integer arithmetic in other units finds the same routes.
+  using FixedPoint = graph::FixedPoint<uint32_t, 1000>;
+  const auto graph = RandomGraph(150, 600, 5);
+  graph::DirectedWeightedGraph<FixedPoint> fixed_graph(150);
+  for (graph::EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+    const auto &edge = graph.GetEdge(edge_id);
+    fixed_graph.AddEdge({edge.from, edge.to, FixedPoint(edge.weight)});
+  }
+
+  const graph::Router<int> router(graph);
+  const graph::Router<FixedPoint> fixed_router(fixed_graph);
+  std::vector<graph::EdgeId> want_edges, got_edges;
+  for (graph::VertexId from = 0; from < 150; ++from) {
+    for (graph::VertexId to = 0; to < 150; ++to) {
+      const auto want = router.BuildRoute(from, to, want_edges);
+      const auto got = fixed_router.BuildRoute(from, to, got_edges);
+      EXPECT_EQ(got, fixed_router.GetWeight(from, to));
+      ASSERT_EQ(want.has_value(), got.has_value());
+      if (!want) continue;
+      EXPECT_EQ(*want, static_cast<double>(*got));
+      EXPECT_EQ(want_edges, got_edges);
+    }
+  }
+}
+
+TEST(TestRouter, TestExternalTables) {
+  auto graph = RandomGraph(100, 400, 0);
+  graph::Router<int> router(graph);
+  const size_t cell_count = router.GetCellCount();
+  const std::vector<int> weights(router.GetWeights(),
+                                 router.GetWeights() + cell_count);
+  const std::vector<graph::EdgeId> prev_edges(
+      router.GetPrevEdges(), router.GetPrevEdges() + cell_count);
+
+  graph::Router<int> wrapped(graph, weights.data(), prev_edges.data());
+  for (graph::VertexId from = 0; from < 100; ++from) {
+    for (graph::VertexId to = 0; to < 100; ++to) {
+      auto want = FindRoute(router, from, to);
+      auto got = FindRoute(wrapped, from, to);
+      ASSERT_EQ(want.has_value(), got.has_value());
+      if (!want) continue;
+
+      EXPECT_EQ(want->weight, got->weight);
+      EXPECT_EQ(want->edges, got->edges);
+    }
+  }
+}
+
+TEST(TestRouter, TestCheckTables) {
+  // One component, so the cell of (from, to) is from * 3 + to.
+  graph::DirectedWeightedGraph<int> graph(3);
+  graph.AddEdge({0, 1, 1});
+  graph.AddEdge({1, 0, 1});
+  graph.AddEdge({1, 2, 1});
+  graph::Router<int> router(graph);
+  EXPECT_TRUE(router.CheckTables());
+  const std::vector<int> weights(router.GetWeights(),
+                                 router.GetWeights() + 9);
+
+  const std::vector<std::pair<std::string, std::vector<std::pair<int, int>>>>
+      damages = {
+      {"Missing edge", {{2, 7}}},
+      {"Edge to other vertex", {{2, 0}}},
+      {"Cycle", {{0, 1}, {1, 0}}},
+  };
+  for (auto &[name, damage] : damages) {
+    std::vector<graph::EdgeId> prev_edges(
+        router.GetPrevEdges(), router.GetPrevEdges() + 9);
+    for (auto [cell, edge_id] : damage) prev_edges[cell] = edge_id;
+    graph::Router<int> wrapped(graph, weights.data(), prev_edges.data());
+    EXPECT_FALSE(wrapped.CheckTables()) << name;
+  }
+}
+
+namespace {
+// Queries a shared router from several threads at once, every thread
+// reusing one edge buffer, and compares with the serial answers.
+template<typename Router>
+void ExpectConcurrentQueries(const graph::DirectedWeightedGraph<int> &graph,
+                             const std::string &name) {
+  const Router router(graph);
+  const size_t vertex_count = graph.GetVertexCount();
+  std::vector<std::optional<Route>> want;
+  for (graph::VertexId from = 0; from < vertex_count; ++from) {
+    for (graph::VertexId to = 0; to < vertex_count; ++to) {
+      want.push_back(FindRoute(router, from, to));
+    }
+  }
+
+  const size_t thread_count = 4;
+  std::vector<std::vector<std::optional<Route>>> got(thread_count);
+  std::vector<std::thread> threads;
+  for (size_t thread = 0; thread < thread_count; ++thread) {
+    threads.emplace_back([&, thread] {
+      std::vector<graph::EdgeId> edges;
+      // Every thread walks the pairs from its own offset.
+      for (size_t i = 0; i < want.size(); ++i) {
+        const size_t pair = (i + thread * want.size() / thread_count) %
+            want.size();
+        auto weight = router.BuildRoute(pair / vertex_count,
+                                        pair % vertex_count,
+                                        edges);
+        got[thread].push_back(
+            weight ? std::optional(Route{*weight, edges}) : std::nullopt);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (size_t thread = 0; thread < thread_count; ++thread) {
+    for (size_t i = 0; i < want.size(); ++i) {
+      const size_t pair = (i + thread * want.size() / thread_count) %
+          want.size();
+      auto &expected = want[pair];
+      auto &actual = got[thread][i];
+      ASSERT_EQ(expected.has_value(), actual.has_value()) << name;
+      if (!expected) continue;
+      EXPECT_EQ(expected->weight, actual->weight) << name;
+      EXPECT_EQ(expected->edges, actual->edges) << name;
+    }
+  }
+}
+}
+
+TEST(TestRouter, TestConcurrentQueries) {
+  const auto graph = RandomGraph(60, 240, 7);
+  ExpectConcurrentQueries<graph::Router<int>>(graph, "Floyd-Warshall");
+  ExpectConcurrentQueries<graph::DijkstraRouter<int>>(graph, "Dijkstra");
+  ExpectConcurrentQueries<graph::ContractionHierarchyRouter<int>>(
+      graph, "Contraction hierarchy");
+  ExpectConcurrentQueries<graph::BidirectionalDijkstraRouter<int>>(
+      graph, "Bidirectional Dijkstra");
+  ExpectConcurrentQueries<graph::HubLabelRouter<int>>(graph, "Hub labels");
+  ExpectConcurrentQueries<graph::TreeCacheRouter<int>>(graph, "Tree cache");
+  ExpectConcurrentQueries<graph::OverlayRouter<int>>(graph, "Overlay");
+}
+
+TEST(TestShortestPathTree, TestRandomGraphs) {
+  for (unsigned seed = 0; seed < 3; ++seed) {
+    const auto graph = RandomGraph(100, 400, seed);
+    const std::string name = "Seed " + std::to_string(seed);
+    const graph::DijkstraRouter<int> router(graph);
+    const graph::CsrGraph<int> csr_graph(graph);
+    // One tree reused for all the roots.
+    graph::ShortestPathTree<int> tree(csr_graph);
+    for (graph::VertexId from = 0; from < 100; ++from) {
+      tree.Build(from);
+      for (graph::VertexId to = 0; to < 100; ++to) {
+        auto want = FindRoute(router, from, to);
+        auto weight = tree.GetWeight(to);
+        ASSERT_EQ(want.has_value(), weight.has_value()) << name;
+        if (!want) continue;
+
+        Route got{*weight, {}};
+        tree.GetRoute(to, got.edges);
+        EXPECT_EQ(want->weight, got.weight) << name;
+        ExpectValidRoute(graph, got, from, to, name);
+      }
+    }
+  }
+}
+
+TEST(TestTreeCacheRouter, TestRandomGraphs) {
+  for (unsigned seed = 0; seed < 5; ++seed) {
+    CompareRouters<graph::DijkstraRouter<int>, graph::TreeCacheRouter<int>>(
+        RandomGraph(60, 200, seed), "Seed " + std::to_string(seed));
+  }
+}
+
+TEST(TestTreeCacheRouter, TestEviction) {
+  const auto graph = RandomGraph(20, 60, 0);
+  const graph::DijkstraRouter<int> dijkstra(graph);
+  const graph::TreeCacheRouter<int> router(graph, 2);
+
+  struct TestCase {
+    graph::VertexId from;
+    size_t want_hit_count;
+    size_t want_miss_count;
+  };
+
+  // The least recently used tree is evicted, whenever it was built.
+  std::vector<TestCase> test_cases{
+      {.from = 0, .want_hit_count = 0, .want_miss_count = 1},
+      {.from = 1, .want_hit_count = 0, .want_miss_count = 2},
+      {.from = 0, .want_hit_count = 1, .want_miss_count = 2},
+      {.from = 2, .want_hit_count = 1, .want_miss_count = 3},
+      {.from = 0, .want_hit_count = 2, .want_miss_count = 3},
+      {.from = 1, .want_hit_count = 2, .want_miss_count = 4},
+  };
+
+  const graph::VertexId to = 19;
+  for (auto &[from, want_hit_count, want_miss_count] : test_cases) {
+    const std::string name = "From " + std::to_string(from);
+    auto want = FindRoute(dijkstra, from, to);
+    auto got = FindRoute(router, from, to);
+    ASSERT_EQ(want.has_value(), got.has_value()) << name;
+    if (want) {
+      EXPECT_EQ(want->weight, got->weight) << name;
+      ExpectValidRoute(graph, *got, from, to, name);
+    }
+    EXPECT_EQ(want_hit_count, router.GetHitCount()) << name;
+    EXPECT_EQ(want_miss_count, router.GetMissCount()) << name;
+  }
+}
@@ -0,0 +1,609 @@
+#include "base_reader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "thread_pool.h"
+
+#include "base_tables.h"
+#include "common.h"
+#include "distance_computer.h"
+#include "request_types.h"
+
+namespace {
+using Duration = rm::IngestionTimes::Duration;
+
+// Adds the time of its scope to `time` unless it's null.
+class StageTimer {
+ public:
+  explicit StageTimer(Duration *time)
+      : time_(time), start_(std::chrono::steady_clock::now()) {}
+  ~StageTimer() {
+    if (time_) *time_ += std::chrono::steady_clock::now() - start_;
+  }
+
+ private:
+  Duration *time_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+Duration *GetStage(rm::IngestionTimes *times,
+                   Duration rm::IngestionTimes::*stage) {
+  return times ? &(times->*stage) : nullptr;
+}
+
+// Offsets of the runs of `lists` once packed into a single column, see
+// StopTable.
+template<typename List>
+std::vector<size_t> ComputeOffsets(const std::vector<List> &lists) {
+  std::vector<size_t> offsets(lists.size() + 1, 0);
+  for (size_t idx = 0; idx < lists.size(); ++idx) {
+    offsets[idx + 1] = offsets[idx] + lists[idx].size();
+  }
+  return offsets;
+}
+
+// Sizes of the runs of `row_count` rows, zero for the rows past `offsets`.
+std::vector<size_t> GetRunSizes(const std::vector<size_t> &offsets,
+                                size_t row_count) {
+  std::vector<size_t> sizes(row_count, 0);
+  for (size_t row = 0; row + 1 < offsets.size(); ++row) {
+    sizes[row] = offsets[row + 1] - offsets[row];
+  }
+  return sizes;
+}
+
+// Offsets of runs of the given sizes.
+std::vector<size_t> SumRunSizes(const std::vector<size_t> &sizes) {
+  std::vector<size_t> offsets(sizes.size() + 1, 0);
+  for (size_t idx = 0; idx < sizes.size(); ++idx) {
+    offsets[idx + 1] = offsets[idx] + sizes[idx];
+  }
+  return offsets;
+}
+
+// Lays the runs of `column` out by `new_offsets`. The runs that change size
+// and those of the new rows are left for the caller to fill.
+template<typename T>
+std::vector<T> MoveRuns(const std::vector<T> &column,
+                        const std::vector<size_t> &offsets,
+                        const std::vector<size_t> &new_offsets) {
+  std::vector<T> result(new_offsets.back());
+  for (size_t row = 0; row + 1 < offsets.size(); ++row) {
+    const size_t size = offsets[row + 1] - offsets[row];
+    if (new_offsets[row + 1] - new_offsets[row] != size) continue;
+    std::copy_n(column.begin() + offsets[row], size,
+                result.begin() + new_offsets[row]);
+  }
+  return result;
+}
+
+constexpr double kRadiansPerDegree = 3.1415926535 / 180;
+
+using RoadDistances = std::vector<std::pair<rm::NameId, int>>;
+
+// Road distances of the stop request, sorted by the other stop.
+RoadDistances GetOwnDistances(const rm::Names &names,
+                              const rm::PostStopRequest &request) {
+  RoadDistances distances;
+  distances.reserve(request.stop_distances.size());
+  for (auto &[stop_to, dist] : request.stop_distances) {
+    distances.emplace_back(*names.stops.Find(stop_to), dist);
+  }
+  std::sort(distances.begin(), distances.end());
+  return distances;
+}
+
+// The distances of a stop: its own ones, and the ones other stops give back
+// to it where it gives none. Both are sorted by the other stop.
+RoadDistances MergeDistances(const RoadDistances &own,
+                             const RoadDistances &back) {
+  RoadDistances merged;
+  merged.reserve(own.size() + back.size());
+  auto it = own.begin();
+  for (auto back_distance : back) {
+    while (it != own.end() && it->first < back_distance.first) {
+      merged.push_back(*it++);
+    }
+    if (it == own.end() || it->first != back_distance.first) {
+      merged.push_back(back_distance);
+    }
+  }
+  merged.insert(merged.end(), it, own.end());
+  return merged;
+}
+
+// Fills all but the bus lists. stop_requests[id] is the request of the stop.
+rm::StopTable ReadStops(
+    const rm::Names &names,
+    const std::vector<const rm::PostStopRequest *> &stop_requests,
+    graph::ThreadPool &pool) {
+  const size_t stop_count = stop_requests.size();
+  rm::StopTable table;
+  table.latitudes.resize(stop_count);
+  table.longitudes.resize(stop_count);
+  // Pairs of the other stop and the distance to it, sorted by the stop.
+  std::vector<RoadDistances> own_distances(stop_count);
+  pool.ParallelFor(stop_count, [&](size_t stop) {
+    auto &request = *stop_requests[stop];
+    table.latitudes[stop] = request.coords.latitude * kRadiansPerDegree;
+    table.longitudes[stop] = request.coords.longitude * kRadiansPerDegree;
+    own_distances[stop] = GetOwnDistances(names, request);
+  });
+
+  // A distance also goes back unless the request of the other stop gives
+  // one. Collected in stop order, so these are sorted too.
+  std::vector<RoadDistances> back_distances(stop_count);
+  for (rm::NameId stop = 0; stop < stop_count; ++stop) {
+    for (auto [stop_to, dist] : own_distances[stop]) {
+      back_distances[stop_to].emplace_back(stop, dist);
+    }
+  }
+
+  std::vector<RoadDistances> distances(stop_count);
+  pool.ParallelFor(stop_count, [&](size_t stop) {
+    distances[stop] =
+        MergeDistances(own_distances[stop], back_distances[stop]);
+  });
+
+  table.dist_offsets = ComputeOffsets(distances);
+  table.dist_stops.resize(table.dist_offsets.back());
+  table.dists.resize(table.dist_offsets.back());
+  pool.ParallelFor(stop_count, [&](size_t stop) {
+    size_t idx = table.dist_offsets[stop];
+    for (auto [stop_to, dist] : distances[stop]) {
+      table.dist_stops[idx] = stop_to;
+      table.dists[idx++] = dist;
+    }
+  });
+  return table;
+}
+
+int ComputeUniqueCount(rm::Span<rm::NameId> route) {
+  std::vector<rm::NameId> stops(route.begin(), route.end());
+  std::sort(begin(stops), end(stops));
+  return std::distance(stops.begin(),
+                       std::unique(begin(stops), end(stops)));
+}
+
+// Fills the route distances and stats of `bus` from its route.
+void ComputeBusStats(rm::NameId bus,
+                     const rm::StopTable &stop_table,
+                     rm::BusTable &table) {
+  const size_t offset = table.stop_offsets[bus];
+  const auto route = table.GetStops(bus);
+  double *road = table.road_distances.data() + offset;
+  double *geo = table.geo_distances.data() + offset;
+  rm::ComputeRoadDistances(route, stop_table, road);
+  rm::ComputeGeoDistances(route, stop_table, geo);
+  table.unique_stop_counts[bus] = ComputeUniqueCount(route);
+  table.curvatures[bus] = road[route.size() - 1] / geo[route.size() - 1];
+}
+
+// bus_requests[id] is the request of the bus.
+rm::BusTable ReadBuses(
+    const rm::Names &names,
+    const std::vector<const rm::PostBusRequest *> &bus_requests,
+    const rm::StopTable &stop_table,
+    graph::ThreadPool &pool) {
+  const size_t bus_count = bus_requests.size();
+  rm::BusTable table;
+  table.stop_offsets.resize(bus_count + 1, 0);
+  for (size_t bus = 0; bus < bus_count; ++bus) {
+    table.stop_offsets[bus + 1] =
+        table.stop_offsets[bus] + bus_requests[bus]->stops.size();
+  }
+  table.stops.resize(table.stop_offsets.back());
+  table.road_distances.resize(table.stop_offsets.back());
+  table.geo_distances.resize(table.stop_offsets.back());
+  table.unique_stop_counts.resize(bus_count);
+  table.curvatures.resize(bus_count);
+
+  pool.ParallelFor(bus_count, [&](size_t bus) {
+    const size_t offset = table.stop_offsets[bus];
+    auto &request_stops = bus_requests[bus]->stops;
+    for (size_t idx = 0; idx < request_stops.size(); ++idx) {
+      table.stops[offset + idx] = *names.stops.Find(request_stops[idx]);
+    }
+
+    ComputeBusStats(bus, stop_table, table);
+  });
+  return table;
+}
+
+// Fills the bus lists of the stops.
+void ReadStopBuses(const rm::Names &names,
+                   const rm::BusTable &bus_table,
+                   rm::StopTable &stop_table,
+                   graph::ThreadPool &pool) {
+  // Ranks of the buses in name order, the order of the lists.
+  std::vector<rm::NameId> by_name(bus_table.GetSize());
+  for (rm::NameId bus = 0; bus < by_name.size(); ++bus) {
+    by_name[bus] = bus;
+  }
+  std::sort(by_name.begin(), by_name.end(), [&](auto lhs, auto rhs) {
+    return names.buses.GetName(lhs) < names.buses.GetName(rhs);
+  });
+  std::vector<size_t> ranks(by_name.size());
+  for (size_t rank = 0; rank < by_name.size(); ++rank) {
+    ranks[by_name[rank]] = rank;
+  }
+
+  std::vector<std::vector<rm::NameId>> stop_buses(stop_table.GetSize());
+  for (rm::NameId bus = 0; bus < bus_table.GetSize(); ++bus) {
+    for (auto stop : bus_table.GetStops(bus)) {
+      stop_buses[stop].push_back(bus);
+    }
+  }
+  pool.ParallelFor(stop_buses.size(), [&](size_t stop) {
+    auto &buses = stop_buses[stop];
+    std::sort(buses.begin(), buses.end(), [&](auto lhs, auto rhs) {
+      return ranks[lhs] < ranks[rhs];
+    });
+    buses.erase(std::unique(buses.begin(), buses.end()), buses.end());
+  });
+
+  stop_table.bus_offsets = ComputeOffsets(stop_buses);
+  stop_table.buses.resize(stop_table.bus_offsets.back());
+  pool.ParallelFor(stop_buses.size(), [&](size_t stop) {
+    std::copy(stop_buses[stop].begin(), stop_buses[stop].end(),
+              stop_table.buses.begin() + stop_table.bus_offsets[stop]);
+  });
+}
+
+// Positions of the requests of the stops and buses in the list of the
+// requests, indexed by id.
+struct RequestPositions {
+  std::vector<size_t> stops;
+  std::vector<size_t> buses;
+};
+
+const rm::PostStopRequest &GetStopRequest(
+    const std::vector<rm::PostRequest> &requests,
+    const RequestPositions &positions,
+    rm::NameId stop) {
+  return std::get<rm::PostStopRequest>(requests[positions.stops[stop]]);
+}
+
+// Applies the requests of the `updated` stops to the coordinates and road
+// distances. `affected` holds the stops their old requests mentioned, which
+// may have lost the distances given back. Returns the stops whose
+// coordinates or distances changed, sorted.
+std::vector<rm::NameId> UpdateStops(
+    const rm::Names &names,
+    const std::vector<rm::PostRequest> &requests,
+    const RequestPositions &positions,
+    const std::vector<rm::NameId> &updated,
+    std::vector<rm::NameId> affected,
+    rm::StopTable &table,
+    rm::BaseChanges &changes) {
+  const size_t old_count = table.GetSize();
+  const size_t stop_count = positions.stops.size();
+  table.latitudes.resize(stop_count);
+  table.longitudes.resize(stop_count);
+  std::vector<rm::NameId> changed;
+  // The updated stops that give a distance to the stop.
+  std::unordered_map<rm::NameId, std::vector<rm::NameId>> given_by;
+  for (auto stop : updated) {
+    auto &request = GetStopRequest(requests, positions, stop);
+    const double latitude = request.coords.latitude * kRadiansPerDegree;
+    const double longitude = request.coords.longitude * kRadiansPerDegree;
+    if (stop >= old_count || table.latitudes[stop] != latitude ||
+        table.longitudes[stop] != longitude) {
+      changes.coords_changed = true;
+      changed.push_back(stop);
+    }
+    table.latitudes[stop] = latitude;
+    table.longitudes[stop] = longitude;
+    affected.push_back(stop);
+    for (auto &[stop_to, _] : request.stop_distances) {
+      const auto other = *names.stops.Find(stop_to);
+      affected.push_back(other);
+      given_by[other].push_back(stop);
+    }
+  }
+  std::sort(affected.begin(), affected.end());
+  affected.erase(std::unique(affected.begin(), affected.end()),
+                 affected.end());
+
+  // Other than the updated stops, only the stops the stop already has
+  // distances with may give one back.
+  std::vector<RoadDistances> runs(affected.size());
+  for (size_t idx = 0; idx < affected.size(); ++idx) {
+    const rm::NameId stop = affected[idx];
+    std::vector<rm::NameId> others = given_by[stop];
+    if (stop < old_count) {
+      others.insert(others.end(),
+                    table.dist_stops.begin() + table.dist_offsets[stop],
+                    table.dist_stops.begin() + table.dist_offsets[stop + 1]);
+    }
+    std::sort(others.begin(), others.end());
+    others.erase(std::unique(others.begin(), others.end()), others.end());
+
+    RoadDistances back;
+    const auto &name = names.stops.GetName(stop);
+    for (auto other : others) {
+      if (other == stop) continue;
+      auto &distances =
+          GetStopRequest(requests, positions, other).stop_distances;
+      if (auto it = distances.find(name); it != distances.end()) {
+        back.emplace_back(other, it->second);
+      }
+    }
+    auto &run = runs[idx];
+    run = MergeDistances(
+        GetOwnDistances(names, GetStopRequest(requests, positions, stop)),
+        back);
+
+    if (stop >= old_count) continue;
+    const size_t offset = table.dist_offsets[stop];
+    bool same = run.size() == table.dist_offsets[stop + 1] - offset;
+    for (size_t i = 0; same && i < run.size(); ++i) {
+      same = run[i].first == table.dist_stops[offset + i] &&
+          run[i].second == table.dists[offset + i];
+    }
+    if (!same) changed.push_back(stop);
+  }
+
+  auto sizes = GetRunSizes(table.dist_offsets, stop_count);
+  for (size_t idx = 0; idx < affected.size(); ++idx) {
+    sizes[affected[idx]] = runs[idx].size();
+  }
+  auto offsets = SumRunSizes(sizes);
+  auto dist_stops = MoveRuns(table.dist_stops, table.dist_offsets, offsets);
+  auto dists = MoveRuns(table.dists, table.dist_offsets, offsets);
+  for (size_t idx = 0; idx < affected.size(); ++idx) {
+    size_t offset = offsets[affected[idx]];
+    for (auto [stop_to, dist] : runs[idx]) {
+      dist_stops[offset] = stop_to;
+      dists[offset++] = dist;
+    }
+  }
+  table.dist_offsets = std::move(offsets);
+  table.dist_stops = std::move(dist_stops);
+  table.dists = std::move(dists);
+
+  std::sort(changed.begin(), changed.end());
+  changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+  return changed;
+}
+
+// A bus whose route got other stops.
+struct Reroute {
+  rm::NameId bus;
+  std::vector<rm::NameId> old_route;
+  std::vector<rm::NameId> route;
+};
+
+// Applies the requests of the `updated` buses to the routes and recomputes
+// the distances and stats of those buses and of the buses through
+// `changed_stops`. The bus lists of `stop_table` must be the old ones.
+std::vector<Reroute> UpdateBuses(
+    const rm::Names &names,
+    const std::vector<rm::PostRequest> &requests,
+    const RequestPositions &positions,
+    const std::vector<rm::NameId> &updated,
+    const std::vector<rm::NameId> &changed_stops,
+    const rm::StopTable &stop_table,
+    rm::BusTable &table,
+    rm::BaseChanges &changes) {
+  const size_t old_count = table.GetSize();
+  const size_t bus_count = positions.buses.size();
+  std::vector<Reroute> reroutes;
+  for (auto bus : updated) {
+    auto &request =
+        std::get<rm::PostBusRequest>(requests[positions.buses[bus]]);
+    std::vector<rm::NameId> route;
+    route.reserve(request.stops.size());
+    for (auto &stop : request.stops) {
+      route.push_back(*names.stops.Find(stop));
+    }
+    if (bus < old_count) {
+      const auto old_route = table.GetStops(bus);
+      if (std::equal(route.begin(), route.end(),
+                     old_route.begin(), old_route.end()))
+        continue;
+      reroutes.push_back({bus, {old_route.begin(), old_route.end()},
+                          std::move(route)});
+    } else {
+      reroutes.push_back({bus, {}, std::move(route)});
+    }
+  }
+
+  if (!reroutes.empty()) {
+    changes.routes_changed = true;
+    auto sizes = GetRunSizes(table.stop_offsets, bus_count);
+    for (auto &reroute : reroutes) {
+      sizes[reroute.bus] = reroute.route.size();
+    }
+    auto offsets = SumRunSizes(sizes);
+    table.stops = MoveRuns(table.stops, table.stop_offsets, offsets);
+    table.road_distances =
+        MoveRuns(table.road_distances, table.stop_offsets, offsets);
+    table.geo_distances =
+        MoveRuns(table.geo_distances, table.stop_offsets, offsets);
+    table.stop_offsets = std::move(offsets);
+    for (auto &reroute : reroutes) {
+      std::copy(reroute.route.begin(), reroute.route.end(),
+                table.stops.begin() + table.stop_offsets[reroute.bus]);
+    }
+  }
+  table.unique_stop_counts.resize(bus_count);
+  table.curvatures.resize(bus_count);
+
+  auto &buses = changes.buses;
+  buses = updated;
+  const size_t listed_stop_count = stop_table.bus_offsets.size() - 1;
+  for (auto stop : changed_stops) {
+    if (stop >= listed_stop_count) continue;
+    auto stop_buses = stop_table.GetBuses(stop);
+    buses.insert(buses.end(), stop_buses.begin(), stop_buses.end());
+  }
+  std::sort(buses.begin(), buses.end());
+  buses.erase(std::unique(buses.begin(), buses.end()), buses.end());
+  for (auto bus : buses) {
+    ComputeBusStats(bus, stop_table, table);
+  }
+  return reroutes;
+}
+
+// Moves the `reroutes` buses between the bus lists of the stops and adds
+// the lists of the new stops.
+void UpdateStopBuses(const rm::Names &names,
+                     const std::vector<Reroute> &reroutes,
+                     rm::StopTable &stop_table) {
+  const size_t old_count = stop_table.bus_offsets.size() - 1;
+  std::vector<rm::NameId> moved, touched;
+  std::unordered_map<rm::NameId, std::vector<rm::NameId>> gained;
+  for (auto &reroute : reroutes) {
+    moved.push_back(reroute.bus);
+    touched.insert(touched.end(),
+                   reroute.old_route.begin(), reroute.old_route.end());
+    touched.insert(touched.end(), reroute.route.begin(), reroute.route.end());
+    for (auto stop : reroute.route) {
+      gained[stop].push_back(reroute.bus);
+    }
+  }
+  std::sort(moved.begin(), moved.end());
+  std::sort(touched.begin(), touched.end());
+  touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+
+  std::vector<std::vector<rm::NameId>> lists(touched.size());
+  for (size_t idx = 0; idx < touched.size(); ++idx) {
+    const rm::NameId stop = touched[idx];
+    auto &list = lists[idx];
+    if (stop < old_count) {
+      for (auto bus : stop_table.GetBuses(stop)) {
+        if (!std::binary_search(moved.begin(), moved.end(), bus)) {
+          list.push_back(bus);
+        }
+      }
+    }
+    auto &buses = gained[stop];
+    list.insert(list.end(), buses.begin(), buses.end());
+    std::sort(list.begin(), list.end(), [&](auto lhs, auto rhs) {
+      return names.buses.GetName(lhs) < names.buses.GetName(rhs);
+    });
+    list.erase(std::unique(list.begin(), list.end()), list.end());
+  }
+
+  auto sizes = GetRunSizes(stop_table.bus_offsets, stop_table.GetSize());
+  for (size_t idx = 0; idx < touched.size(); ++idx) {
+    sizes[touched[idx]] = lists[idx].size();
+  }
+  auto offsets = SumRunSizes(sizes);
+  auto buses = MoveRuns(stop_table.buses, stop_table.bus_offsets, offsets);
+  for (size_t idx = 0; idx < touched.size(); ++idx) {
+    std::copy(lists[idx].begin(), lists[idx].end(),
+              buses.begin() + offsets[touched[idx]]);
+  }
+  stop_table.bus_offsets = std::move(offsets);
+  stop_table.buses = std::move(buses);
+}
+}
+
+namespace rm {
+Base ReadBase(const std::vector<PostRequest> &requests,
+              size_t thread_count,
+              IngestionTimes *times) {
+  // Every stop and bus has a single request, so the requests are listed
+  // in the order of the ids.
+  auto names = std::make_shared<Names>();
+  std::vector<const PostStopRequest *> stop_requests;
+  std::vector<const PostBusRequest *> bus_requests;
+  {
+    StageTimer timer(GetStage(times, &IngestionTimes::names));
+    for (auto &request : requests) {
+      if (auto ptr_b = std::get_if<PostBusRequest>(&request)) {
+        names->buses.Intern(ptr_b->bus);
+        bus_requests.push_back(ptr_b);
+      } else if (auto ptr_s = std::get_if<PostStopRequest>(&request)) {
+        names->stops.Intern(ptr_s->stop);
+        stop_requests.push_back(ptr_s);
+      }
+    }
+  }
+
+  graph::ThreadPool pool(thread_count);
+  Base base;
+  {
+    StageTimer timer(GetStage(times, &IngestionTimes::stops));
+    base.stops = ReadStops(*names, stop_requests, pool);
+  }
+  {
+    StageTimer timer(GetStage(times, &IngestionTimes::buses));
+    base.buses = ReadBuses(*names, bus_requests, base.stops, pool);
+  }
+  {
+    StageTimer timer(GetStage(times, &IngestionTimes::stop_buses));
+    ReadStopBuses(*names, base.buses, base.stops, pool);
+  }
+  base.names = std::move(names);
+  return base;
+}
+}
+
+namespace rm {
+BaseChanges UpdateBase(std::vector<PostRequest> updates,
+                       std::vector<PostRequest> &requests,
+                       Base &base) {
+  Names &names = *base.names;
+  RequestPositions positions;
+  for (size_t pos = 0; pos < requests.size(); ++pos) {
+    if (std::holds_alternative<PostBusRequest>(requests[pos])) {
+      positions.buses.push_back(pos);
+    } else {
+      positions.stops.push_back(pos);
+    }
+  }
+
+  // All the names are interned first, as the requests may mention the new
+  // stops.
+  std::vector<NameId> updated_stops, updated_buses;
+  std::vector<NameId> mentioned;
+  for (auto &update : updates) {
+    if (auto ptr_b = std::get_if<PostBusRequest>(&update)) {
+      const NameId bus = names.buses.Intern(ptr_b->bus);
+      if (bus < positions.buses.size()) {
+        requests[positions.buses[bus]] = std::move(*ptr_b);
+      } else {
+        positions.buses.push_back(requests.size());
+        requests.emplace_back(std::move(*ptr_b));
+      }
+      updated_buses.push_back(bus);
+    } else if (auto ptr_s = std::get_if<PostStopRequest>(&update)) {
+      const NameId stop = names.stops.Intern(ptr_s->stop);
+      if (stop < positions.stops.size()) {
+        auto &request = requests[positions.stops[stop]];
+        for (auto &[stop_to, _] :
+            std::get<PostStopRequest>(request).stop_distances) {
+          mentioned.push_back(*names.stops.Find(stop_to));
+        }
+        request = std::move(*ptr_s);
+      } else {
+        positions.stops.push_back(requests.size());
+        requests.emplace_back(std::move(*ptr_s));
+      }
+      updated_stops.push_back(stop);
+    }
+  }
+
+  BaseChanges changes;
+  changes.routes_changed = positions.stops.size() > base.stops.GetSize();
+  const auto changed_stops =
+      UpdateStops(names, requests, positions, updated_stops,
+                  std::move(mentioned), base.stops, changes);
+  const auto reroutes =
+      UpdateBuses(names, requests, positions, updated_buses, changed_stops,
+                  base.stops, base.buses, changes);
+  if (changes.routes_changed) {
+    UpdateStopBuses(names, reroutes, base.stops);
+  }
+  return changes;
+}
+}
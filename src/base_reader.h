@@ -0,0 +1,64 @@
+#ifndef ROOT_MANAGER_SRC_BASE_READER_H_
+#define ROOT_MANAGER_SRC_BASE_READER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+#include "common.h"
+#include "request_types.h"
+
+namespace rm {
+// Wall time of the stages of loading the base requests.
+struct IngestionTimes {
+  using Duration = std::chrono::steady_clock::duration;
+
+  // Interning the names.
+  Duration names{};
+  // Coordinates and road distances of the stops.
+  Duration stops{};
+  // Routes, route distances and stats of the buses.
+  Duration buses{};
+  // Bus lists of the stops.
+  Duration stop_buses{};
+  // Building the RouteManager, filled by BusManager.
+  Duration router{};
+};
+
+// Interns the names of the stops and buses in the order of their requests
+// and fills the tables, including the route distances and stats. The
+// requests must be valid, see BusManager::Create: every stop and bus has a
+// single request, and every stop a request mentions has one.
+//
+// The stages run per stop and per bus on `thread_count` threads, and give
+// the same tables for any thread count. Adds their times to `times` when
+// it's given.
+Base ReadBase(const std::vector<PostRequest> &requests,
+              size_t thread_count = 1,
+              IngestionTimes *times = nullptr);
+
+// Rows of the base recomputed by UpdateBase.
+struct BaseChanges {
+  // Buses whose routes, route distances or stats were recomputed, sorted.
+  std::vector<NameId> buses;
+  // Some stop got new coordinates.
+  bool coords_changed = false;
+  // Some stop or bus is new or some route got other stops, so the network
+  // changed its shape rather than its distances.
+  bool routes_changed = false;
+};
+
+// Applies `updates` to `requests`, the requests `base` was read from: the
+// request of a known stop or bus is replaced, and the others are appended, so
+// the new names get the next ids. Recomputes only the rows of the base the
+// updates affect, and leaves it as ReadBase would read the updated requests.
+// The updated requests must be valid, see BusManager::Create.
+//
+// Time: O(S+D+R) to repack the columns plus the work on the affected rows,
+// S - number of stops, D - of road distances, R - of route stops.
+BaseChanges UpdateBase(std::vector<PostRequest> updates,
+                       std::vector<PostRequest> &requests,
+                       Base &base);
+}
+
+#endif // ROOT_MANAGER_SRC_BASE_READER_H_
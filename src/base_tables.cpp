@@ -0,0 +1,46 @@
+#include "base_tables.h"
+
+#include <algorithm>
+#include <optional>
+
+namespace rm {
+size_t StopTable::GetSize() const {
+  return latitudes.size();
+}
+
+sphere::Coords StopTable::GetCoords(NameId stop) const {
+  return {latitudes[stop], longitudes[stop]};
+}
+
+std::optional<int> StopTable::GetRoadDistance(NameId from, NameId to) const {
+  auto begin = dist_stops.begin() + dist_offsets[from];
+  auto end = dist_stops.begin() + dist_offsets[from + 1];
+  auto found = std::lower_bound(begin, end, to);
+  if (found == end || *found != to) return std::nullopt;
+  return dists[found - dist_stops.begin()];
+}
+
+Span<NameId> StopTable::GetBuses(NameId stop) const {
+  return {buses.data() + bus_offsets[stop],
+          buses.data() + bus_offsets[stop + 1]};
+}
+
+size_t BusTable::GetSize() const {
+  return stop_offsets.empty() ? 0 : stop_offsets.size() - 1;
+}
+
+Span<NameId> BusTable::GetStops(NameId bus) const {
+  return {stops.data() + stop_offsets[bus],
+          stops.data() + stop_offsets[bus + 1]};
+}
+
+Span<double> BusTable::GetRoadDistances(NameId bus) const {
+  return {road_distances.data() + stop_offsets[bus],
+          road_distances.data() + stop_offsets[bus + 1]};
+}
+
+Span<double> BusTable::GetGeoDistances(NameId bus) const {
+  return {geo_distances.data() + stop_offsets[bus],
+          geo_distances.data() + stop_offsets[bus + 1]};
+}
+}
@@ -0,0 +1,74 @@
+#ifndef ROOT_MANAGER_SRC_BASE_TABLES_H_
+#define ROOT_MANAGER_SRC_BASE_TABLES_H_
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include "name_table.h"
+#include "sphere.h"
+
+namespace rm {
+// Read-only view of a run of a column.
+template<typename T>
+class Span {
+ public:
+  Span(const T *begin, const T *end) : begin_(begin), end_(end) {}
+
+  const T *begin() const { return begin_; }
+  const T *end() const { return end_; }
+  size_t size() const { return end_ - begin_; }
+  bool empty() const { return begin_ == end_; }
+  const T &operator[](size_t idx) const { return begin_[idx]; }
+  const T &front() const { return *begin_; }
+  const T &back() const { return *(end_ - 1); }
+
+ private:
+  const T *begin_;
+  const T *end_;
+};
+
+// The stops, indexed by id and stored by column. Lists of a stop lie in
+// runs of a shared column: the run of stop s is [offsets[s], offsets[s + 1]).
+struct StopTable {
+  size_t GetSize() const;
+  sphere::Coords GetCoords(NameId stop) const;
+  // Road distance from `from` to `to`, nullopt when there is none.
+  // Time: O(log(D)), D - number of the distances from `from`.
+  std::optional<int> GetRoadDistance(NameId from, NameId to) const;
+  // Sorted by name, without repeats.
+  Span<NameId> GetBuses(NameId stop) const;
+
+  // In radians.
+  std::vector<double> latitudes;
+  std::vector<double> longitudes;
+  // Road distances to other stops, sorted by the id of the other stop.
+  std::vector<size_t> dist_offsets;
+  std::vector<NameId> dist_stops;
+  std::vector<int> dists;
+  // Buses through the stop.
+  std::vector<size_t> bus_offsets;
+  std::vector<NameId> buses;
+};
+
+// The buses, indexed by id and stored by column. The route of bus b takes
+// the run [stop_offsets[b], stop_offsets[b + 1]) of the route columns.
+struct BusTable {
+  size_t GetSize() const;
+  Span<NameId> GetStops(NameId bus) const;
+  // Distances from the first stop of the route to each of its stops, so the
+  // distance of any span is the difference of two of them.
+  Span<double> GetRoadDistances(NameId bus) const;
+  Span<double> GetGeoDistances(NameId bus) const;
+
+  std::vector<size_t> stop_offsets;
+  std::vector<NameId> stops;
+  std::vector<double> road_distances;
+  std::vector<double> geo_distances;
+  // Route stats.
+  std::vector<int> unique_stop_counts;
+  std::vector<double> curvatures;
+};
+}
+
+#endif // ROOT_MANAGER_SRC_BASE_TABLES_H_
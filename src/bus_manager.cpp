@@ -1,133 +1,131 @@
 #include "bus_manager.h"
 
 #include <algorithm>
-#include <map>
+#include <chrono>
 #include <optional>
 #include <set>
 #include <string>
 #include <string_view>
-#include <unordered_map>
 #include <utility>
 #include <variant>
 #include <vector>
 
-#include "distance_computer.h"
+#include "base_reader.h"
 
 namespace {
-int ComputeUniqueCount(std::vector<std::string> stops) {
-  std::sort(begin(stops), end(stops));
-  return std::distance(stops.begin(),
-                       std::unique(begin(stops), end(stops)));
-}
-}
-
-namespace rm {
-std::unique_ptr<BusManager> BusManager::Create(
-    std::vector<PostRequest> requests,
-    const RoutingSettings &routing_settings) {
+// Whether `requests` may be added to the stops and buses of `names`: every
+// bus has stops, no name has two requests, and every stop the requests
+// mention has one or is known.
+bool ValidateRequests(const std::vector<rm::PostRequest> &requests,
+                      const rm::Names *names) {
   std::set<std::string_view> route_stops, road_dists_stops, stop_requests_stops;
   std::set<std::string_view> buses;
   for (auto &req : requests) {
-    if (auto ptr_b = std::get_if<PostBusRequest>(&req)) {
-      if (ptr_b->stops.empty()) return nullptr;
+    if (auto ptr_b = std::get_if<rm::PostBusRequest>(&req)) {
+      if (ptr_b->stops.empty()) return false;
       route_stops.insert(ptr_b->stops.begin(), ptr_b->stops.end());
       if (!buses.insert(ptr_b->bus).second)
-        return nullptr;
-    } else if (auto ptr_s = std::get_if<PostStopRequest>(&req)) {
+        return false;
+    } else if (auto ptr_s = std::get_if<rm::PostStopRequest>(&req)) {
       for (auto &[dst_stop, dist] : ptr_s->stop_distances) {
         road_dists_stops.insert(dst_stop);
       }
       if (!stop_requests_stops.insert(ptr_s->stop).second)
-        return nullptr;
+        return false;
     }
   }
-  if (!std::includes(begin(stop_requests_stops), end(stop_requests_stops),
-                     begin(route_stops), end(route_stops)))
-    return nullptr;
-  if (!std::includes(begin(stop_requests_stops), end(stop_requests_stops),
-                     begin(road_dists_stops), end(road_dists_stops)))
-    return nullptr;
+  auto is_known = [&](std::string_view stop) {
+    return stop_requests_stops.count(stop) ||
+        (names && names->stops.Find(stop));
+  };
+  return std::all_of(begin(route_stops), end(route_stops), is_known) &&
+      std::all_of(begin(road_dists_stops), end(road_dists_stops), is_known);
+}
+}
+
+namespace rm {
+std::unique_ptr<BusManager> BusManager::Create(
+    std::vector<PostRequest> requests,
+    const RoutingSettings &routing_settings) {
+  if (!ValidateRequests(requests, nullptr)) return nullptr;
 
   return std::unique_ptr<BusManager>(new BusManager(std::move(requests),
                                                     routing_settings));
 }
 
 BusManager::BusManager(std::vector<PostRequest> requests,
-                       const RoutingSettings &routing_settings) {
-  for (auto &request : requests) {
-    if (std::holds_alternative<PostBusRequest>(request)) {
-      auto &bus = std::get<PostBusRequest>(request);
-      AddBus(std::move(bus.bus), std::move(bus.stops));
-    } else if (std::holds_alternative<PostStopRequest>(request)) {
-      auto &stop = std::get<PostStopRequest>(request);
-      AddStop(stop.stop,
-              stop.coords,
-              stop.stop_distances);
-    }
-  }
-
-  for (auto &[bus, bus_info] : bus_info_) {
-    double geo_dist = ComputeGeoDistance(bus_info.stops, stop_info_);
-    bus_info.distance = ComputeRoadDistance(bus_info.stops, stop_info_);
-    bus_info.unique_stop_count = ComputeUniqueCount(bus_info.stops);
-    bus_info.curvature = bus_info.distance / geo_dist;
-  }
-  for (auto &[_, info] : stop_info_) {
-    auto &buses = info.buses;
-    std::sort(buses.begin(), buses.end());
-    buses.erase(std::unique(buses.begin(), buses.end()),
-                buses.end());
-  }
-  route_manager_ =
-      std::make_unique<RouteManager>(stop_info_, bus_info_, routing_settings);
+                       const RoutingSettings &routing_settings)
+    : requests_(std::move(requests)),
+      base_(ReadBase(requests_, routing_settings.router_threads, &times_)) {
+  auto start = std::chrono::steady_clock::now();
+  route_manager_ = std::make_unique<RouteManager>(base_, routing_settings);
+  times_.router = std::chrono::steady_clock::now() - start;
 }
 
-void BusManager::AddStop(const std::string &stop, sphere::Coords coords,
-                         const std::map<std::string, int> &stops) {
-  constexpr double k = 3.1415926535 / 180;
-  auto &info = stop_info_[stop];
-  info.coords = {coords.latitude * k, coords.longitude * k};
-  for (auto &[stop_to, dist] : stops) {
-    auto &stop_to_dists = stop_info_[stop_to].dists;
-    if (auto it = stop_to_dists.find(stop); it == stop_to_dists.end()) {
-      stop_to_dists[stop] = dist;
-    }
-    info.dists[stop_to] = dist;
-  }
-}
+std::optional<BaseChanges> BusManager::Update(
+    std::vector<PostRequest> requests) {
+  if (!ValidateRequests(requests, base_.names.get())) return std::nullopt;
 
-void BusManager::AddBus(std::string bus, std::vector<std::string> stops) {
-  for (auto &stop : stops)
-    stop_info_[stop].buses.push_back(bus);
-
-  BusInfo bus_info;
-  bus_info.stops = std::move(stops);
-  bus_info_[std::move(bus)] = bus_info;
+  auto changes = UpdateBase(std::move(requests), requests_, base_);
+  route_manager_->Update(base_, changes);
+  return changes;
 }
 
 std::optional<BusResponse> BusManager::GetBusInfo(const std::string &bus) const {
-  auto it = bus_info_.find(bus);
-  if (it == bus_info_.end()) return std::nullopt;
+  auto id = base_.names->buses.Find(bus);
+  if (!id) return std::nullopt;
 
-  auto &b = it->second;
+  auto &buses = base_.buses;
   return BusResponse{
-      .stop_count = static_cast<int>(b.stops.size()),
-      .unique_stop_count = b.unique_stop_count,
-      .length = b.distance,
-      .curvature = b.curvature,
+      .stop_count = static_cast<int>(buses.GetStops(*id).size()),
+      .unique_stop_count = buses.unique_stop_counts[*id],
+      .length = buses.GetRoadDistances(*id).back(),
+      .curvature = buses.curvatures[*id],
   };
 }
 
 std::optional<StopResponse> BusManager::GetStopInfo(const std::string &stop) const {
-  auto it = stop_info_.find(stop);
-  if (it == stop_info_.end())
+  auto id = base_.names->stops.Find(stop);
+  if (!id)
     return std::nullopt;
 
-  return StopResponse{it->second.buses};
+  StopResponse response;
+  for (auto bus : base_.stops.GetBuses(*id)) {
+    response.buses.push_back(base_.names->buses.GetName(bus));
+  }
+  return response;
 }
 
 std::optional<RouteResponse> BusManager::GetRoute(const std::string &from,
                                                   const std::string &to) const {
   return route_manager_->FindRoute(from, to);
 }
+
+RouteMatrixResponse BusManager::GetRouteMatrix(
+    const std::vector<std::string> &sources,
+    const std::vector<std::string> &targets,
+    bool with_items) const {
+  RouteMatrixResponse response;
+  for (auto &source : sources) {
+    response.times.push_back(route_manager_->FindRouteTimes(source, targets));
+    if (!with_items) continue;
+    auto &routes = response.routes.emplace_back();
+    for (auto &target : targets) {
+      routes.push_back(route_manager_->FindRoute(source, target));
+    }
+  }
+  return response;
+}
+
+std::optional<TreeCacheStats> BusManager::GetTreeCacheStats() const {
+  return route_manager_->GetTreeCacheStats();
+}
+
+const std::vector<PostRequest> &BusManager::GetRequests() const {
+  return requests_;
+}
+
+const IngestionTimes &BusManager::GetIngestionTimes() const {
+  return times_;
+}
 }
@@ -1,12 +1,12 @@
 #ifndef ROOT_MANAGER_SRC_BUS_MANAGER_H_
 #define ROOT_MANAGER_SRC_BUS_MANAGER_H_
 
-#include <map>
 #include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "base_reader.h"
 #include "common.h"
 #include "request_types.h"
 #include "route_manager.h"
@@ -25,6 +25,13 @@ struct StopResponse {
 
 using RouteResponse = RouteInfo;
 
+struct RouteMatrixResponse {
+  // times[i][j] - time of the route from the i-th source to the j-th target.
+  std::vector<std::vector<std::optional<double>>> times;
+  // The routes themselves, in the same order, when the items were requested.
+  std::vector<std::vector<std::optional<RouteResponse>>> routes;
+};
+
 class BusManager {
  public:
   static std::unique_ptr<BusManager> Create(
@@ -35,21 +42,36 @@ class BusManager {
 
   std::optional<StopResponse> GetStopInfo(const std::string &stop) const;
 
+  // Applies new and replacing stop and bus requests, see UpdateBase, and
+  // updates the routes. Returns nullopt and changes nothing when the updated
+  // requests would be invalid. Mustn't run concurrently with the queries.
+  std::optional<BaseChanges> Update(std::vector<PostRequest> requests);
+
   std::optional<RouteResponse> GetRoute(const std::string &from,
                                         const std::string &to) const;
 
+  RouteMatrixResponse GetRouteMatrix(const std::vector<std::string> &sources,
+                                     const std::vector<std::string> &targets,
+                                     bool with_items) const;
+
+  // See RouteManager::GetTreeCacheStats.
+  std::optional<TreeCacheStats> GetTreeCacheStats() const;
+
+  // The requests the manager is built from, the updates included, the
+  // requests of the stops and buses in the order of their ids.
+  const std::vector<PostRequest> &GetRequests() const;
+
+  // Times of the stages of the construction.
+  const IngestionTimes &GetIngestionTimes() const;
+
  private:
   explicit BusManager(std::vector<PostRequest> requests,
                       const RoutingSettings &routing_settings);
 
-  void AddStop(const std::string &stop, sphere::Coords coords,
-               const std::map<std::string, int> &stops);
-
-  void AddBus(std::string bus, std::vector<std::string> stops);
-
  private:
-  StopDict stop_info_;
-  BusDict bus_info_;
+  IngestionTimes times_;
+  std::vector<PostRequest> requests_;
+  Base base_;
   std::unique_ptr<RouteManager> route_manager_;
 };
 }
@@ -1,13 +1,16 @@
 #ifndef ROOT_MANAGER_SRC_COMMON_H_
 #define ROOT_MANAGER_SRC_COMMON_H_
 
+#include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <variant>
 #include <vector>
-#include <unordered_map>
 #include <unordered_set>
 
+#include "base_tables.h"
+#include "name_table.h"
 #include "request_types.h"
 
 namespace rm {
@@ -16,21 +19,6 @@ struct Route {
   std::unordered_set<std::string_view> endpoints;
 };
 
-struct StopInfo {
-  using Dists = std::unordered_map<std::string, int>;
-  // Distances to other stops.
-  Dists dists;
-  sphere::Coords coords;
-  std::vector<std::string> buses;
-};
-
-struct BusInfo {
-  std::vector<std::string> stops;
-  int unique_stop_count;
-  double distance;
-  double curvature;
-};
-
 struct RouteInfo {
   struct RoadItem {
     std::string bus;
@@ -47,10 +35,25 @@ struct RouteInfo {
 
   double time;
   std::vector<Item> items;
+  // Vertices the query settled, for the routers that search per query and
+  // count them.
+  std::optional<size_t> settled_count;
 };
 
-using StopDict = std::unordered_map<std::string, StopInfo>;
-using BusDict = std::unordered_map<std::string, BusInfo>;
+struct Names {
+  NameTable stops;
+  NameTable buses;
+};
+
+// The stops and buses of the base requests, indexed by the ids of their
+// names. The names are shared by all the parts built from the base. Only
+// UpdateBase adds to them, and the new names get new ids, so the parts keep
+// resolving the ids they hold.
+struct Base {
+  std::shared_ptr<Names> names;
+  StopTable stops;
+  BusTable buses;
+};
 
 template<typename C, typename ...Args>
 void Combine(C &container, Args... args) {
@@ -1,33 +1,32 @@
 #include "distance_computer.h"
 
-#include <string>
-#include <vector>
-
-#include "common.h"
+#include "base_tables.h"
+#include "name_table.h"
+#include "sphere.h"
 
 namespace rm {
-double ComputeGeoDistance(const std::vector<std::string> &stops,
-                          const StopDict &dict) {
-  double distance = 0;
+void ComputeGeoDistances(Span<NameId> stops, const StopTable &table,
+                         double *distances) {
+  if (stops.empty()) return;
+  distances[0] = 0.0;
   for (int i = 1; i < stops.size(); ++i) {
-    distance += sphere::CalculateDistance(dict.at(stops[i - 1]).coords,
-                                          dict.at(stops[i]).coords);
+    distances[i] = distances[i - 1] +
+        sphere::CalculateDistance(table.GetCoords(stops[i - 1]),
+                                  table.GetCoords(stops[i]));
   }
-  return distance;
 }
 
-double ComputeRoadDistance(const std::vector<std::string> &stops,
-                           const StopDict &dict) {
-  double distance = 0;
+void ComputeRoadDistances(Span<NameId> stops, const StopTable &table,
+                          double *distances) {
+  if (stops.empty()) return;
+  distances[0] = 0.0;
   for (int i = 1; i < stops.size(); ++i) {
-    auto &dists = dict.at(stops[i - 1]).dists;
-
-    if (auto found = dists.find(stops[i]); found != dists.end())
-      distance += found->second;
+    if (auto dist = table.GetRoadDistance(stops[i - 1], stops[i]))
+      distances[i] = distances[i - 1] + *dist;
     else
-      distance += sphere::CalculateDistance(dict.at(stops[i - 1]).coords,
-                                            dict.at(stops[i]).coords);
+      distances[i] = distances[i - 1] +
+          sphere::CalculateDistance(table.GetCoords(stops[i - 1]),
+                                    table.GetCoords(stops[i]));
   }
-  return distance;
 }
 }
@@ -1,17 +1,19 @@
 #ifndef ROOT_MANAGER_SRC_DISTANCE_COMPUTER_H_
 #define ROOT_MANAGER_SRC_DISTANCE_COMPUTER_H_
 
-#include <string>
-#include <vector>
-
-#include "common.h"
+#include "base_tables.h"
+#include "name_table.h"
 
 namespace rm {
-double ComputeGeoDistance(const std::vector<std::string> &stops,
-                          const StopDict &dict);
+// Both write the distances from the first stop of the route to each of its
+// stops to distances[0..stops.size()), so the distance of any span is the
+// difference of two of them.
+void ComputeGeoDistances(Span<NameId> stops, const StopTable &table,
+                         double *distances);
 
-double ComputeRoadDistance(const std::vector<std::string> &stops,
-                           const StopDict &dict);
+// Segments without a road distance count the geo one.
+void ComputeRoadDistances(Span<NameId> stops, const StopTable &table,
+                          double *distances);
 }
 
 #endif // ROOT_MANAGER_SRC_DISTANCE_COMPUTER_H_
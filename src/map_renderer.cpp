@@ -103,22 +103,32 @@ svg::Circle StopPoint(svg::Point center, double radius) {
       .SetRadius(radius);
 }
 
-std::unordered_map<std::string, svg::Point> CombineCoords(
+rm::NameTable InternStops(const rm::renderer_utils::Stops &stops) {
+  rm::NameTable stop_names;
+  for (auto [stop, _] : stops) {
+    stop_names.Intern(stop);
+  }
+  return stop_names;
+}
+
+std::vector<svg::Point> CombineCoords(
     const std::vector<std::pair<std::string_view, double>> &x_coords,
-    const std::vector<std::pair<std::string_view, double>> &y_coords) {
-  std::unordered_map<std::string, svg::Point> result;
+    const std::vector<std::pair<std::string_view, double>> &y_coords,
+    const rm::NameTable &stop_names) {
+  std::vector<svg::Point> result(stop_names.GetSize());
   for (auto &[stop, x_coord] : x_coords) {
-    result[std::string(stop)].x = x_coord;
+    result[*stop_names.Find(stop)].x = x_coord;
   }
   for (auto &[stop, y_coord] : y_coords) {
-    result[std::string(stop)].y = y_coord;
+    result[*stop_names.Find(stop)].y = y_coord;
   }
   return result;
 }
 
-std::unordered_map<std::string, svg::Point> TransformCoords(
+std::vector<svg::Point> TransformCoords(
     const rm::renderer_utils::Buses &buses,
     rm::renderer_utils::Stops &stops,
+    const rm::NameTable &stop_names,
     const rm::Frame &frame) {
   using namespace rm::coords_converter;
 
@@ -143,7 +153,7 @@ std::unordered_map<std::string, svg::Point> TransformCoords(
   auto y_coords = SpreadStops(layers_by_lat,
                               frame.height - frame.padding, frame.padding);
 
-  return CombineCoords(x_coords, y_coords);
+  return CombineCoords(x_coords, y_coords, stop_names);
 }
 
 template<typename Func>
@@ -165,31 +175,39 @@ std::unique_ptr<MapRenderer> MapRenderer::Create(
     renderer_utils::Stops stops,
     const RenderingSettings &settings) {
   if (settings.color_palette.empty()) return nullptr;
+  if (!Validate(buses, stops)) return nullptr;
 
+  for (auto &[bus, route] : buses) {
+    for (auto stop : route.route) {
+      if (stops.find(stop) == stops.end())
+        return nullptr;
+    }
+  }
+
+  return std::unique_ptr<MapRenderer>(new MapRenderer(buses, std::move(stops),
+                                                      settings));
+}
+
+bool MapRenderer::Validate(const renderer_utils::Buses &buses,
+                           const renderer_utils::Stops &stops) {
   for (auto [_, coords] : stops) {
     auto lat = coords.latitude, lon = coords.longitude;
     if (lat < kMinLatitude || lat > kMaxLatitude ||
         lon < kMinLongitude || lon > kMaxLongitude)
-      return nullptr;
+      return false;
   }
 
   for (auto &[bus, route] : buses) {
     if (route.route.size() < 3 || route.route.front() != route.route.back())
-      return nullptr;
-    for (auto stop : route.route) {
-      if (stops.find(stop) == stops.end())
-        return nullptr;
-    }
+      return false;
     std::unordered_set<std::string_view> route_stops(route.route.begin(),
                                                      route.route.end());
     for (auto endpoint : route.endpoints) {
       if (route_stops.find(endpoint) == route_stops.end())
-        return nullptr;
+        return false;
     }
   }
-
-  return std::unique_ptr<MapRenderer>(new MapRenderer(buses, std::move(stops),
-                                                      settings));
+  return true;
 }
 
 MapRenderer::MapRenderer(
@@ -197,8 +215,9 @@ MapRenderer::MapRenderer(
     renderer_utils::Stops stops,
     const RenderingSettings &settings)
     : map_(svg::SectionBuilder{}.Build()),
-      buses_(ConstructBuses(buses, settings)),
-      stop_coords_(TransformCoords(buses, stops, settings.frame)),
+      stop_names_(InternStops(stops)),
+      buses_(ConstructBuses(buses, stop_names_, settings)),
+      stop_coords_(TransformCoords(buses, stops, stop_names_, settings.frame)),
       settings_(settings) {
   svg::SectionBuilder builder;
   for (auto layer : settings.layers) {
@@ -217,13 +236,12 @@ MapRenderer::MapRenderer(
         break;
       case MapLayer::kStopPoints:
         AddStopPointsLayout(builder,
-                            stops,
                             settings,
                             stop_coords_);
         break;
       case MapLayer::kStopLabels:
         AddStopLabelsLayout(builder,
-                            stops,
+                            stop_names_,
                             settings,
                             stop_coords_);
         break;
@@ -233,7 +251,9 @@ MapRenderer::MapRenderer(
 }
 
 MapRenderer::Buses MapRenderer::ConstructBuses(
-    const renderer_utils::Buses &buses, const RenderingSettings &settings) {
+    const renderer_utils::Buses &buses,
+    const NameTable &stop_names,
+    const RenderingSettings &settings) {
   Buses result;
   int i = 0;
   for (auto &[bus, route] : buses) {
@@ -241,13 +261,20 @@ MapRenderer::Buses MapRenderer::ConstructBuses(
     i = (i + 1) % settings.color_palette.size();
     auto &bus_info = result[std::string(bus)];
     bus_info = {
-        .route = {route.route.begin(), route.route.end()},
-        .endpoints = [&r = route]() {
-          std::vector<std::string> res;
+        .route = [&r = route, &stop_names]() {
+          std::vector<NameId> res;
+          res.reserve(r.route.size());
+          for (auto stop : r.route) {
+            res.push_back(*stop_names.Find(stop));
+          }
+          return res;
+        }(),
+        .endpoints = [&r = route, &stop_names]() {
+          std::vector<NameId> res;
           auto endpoints = r.endpoints;
           for (auto &stop : r.route) {
             if (auto found = endpoints.find(stop); found != endpoints.end()) {
-              res.emplace_back(*found);
+              res.push_back(*stop_names.Find(*found));
               endpoints.erase(found);
             }
           }
@@ -271,12 +298,12 @@ MapRenderer::SortBusNames(const MapRenderer::Buses &buses) {
 }
 
 std::vector<svg::Point> MapRenderer::Points(
-    const std::vector<std::string> &route,
+    const std::vector<NameId> &route,
     const StopCoords &coords) {
   std::vector<svg::Point> points;
   points.reserve(route.size());
-  for (auto &stop : route) {
-    points.push_back(coords.at(stop));
+  for (auto stop : route) {
+    points.push_back(coords[stop]);
   }
   return points;
 }
@@ -320,30 +347,27 @@ void MapRenderer::AddBusLabelsLayout(
   for (auto &bus : SortBusNames(buses)) {
     auto &bus_info = buses.at(bus);
     for (auto &endpoint : bus_info.endpoints) {
-      builder.Add(BusName(bus, coords.at(endpoint), bus_info.color, settings));
+      builder.Add(BusName(bus, coords[endpoint], bus_info.color, settings));
     }
   }
 }
 
 void MapRenderer::AddStopPointsLayout(
     svg::SectionBuilder &builder,
-    const renderer_utils::Stops &stops,
     const rm::RenderingSettings &settings,
     const StopCoords &coords) {
-  for (auto [stop, _] : stops) {
-    builder.Add(StopPoint(coords.at(std::string(stop)), settings.stop_radius));
+  for (auto point : coords) {
+    builder.Add(StopPoint(point, settings.stop_radius));
   }
 }
 
 void MapRenderer::AddStopLabelsLayout(
     svg::SectionBuilder &builder,
-    const renderer_utils::Stops &stops,
+    const NameTable &stop_names,
     const rm::RenderingSettings &settings,
     const StopCoords &coords) {
-  for (auto [stop, _] : stops) {
-    builder.Add(StopName(std::string(stop),
-                         coords.at(std::string(stop)),
-                         settings));
+  for (NameId stop = 0; stop < coords.size(); ++stop) {
+    builder.Add(StopName(stop_names.GetName(stop), coords[stop], settings));
   }
 }
 
@@ -362,11 +386,11 @@ svg::Section MapRenderer::BusLabelsFor(const RouteInfo::RoadItem &item) const {
   auto &bus_info = buses_.at(item.bus);
   auto &endpoints = bus_info.endpoints;
 
-  auto &start_stop = bus_info.route[item.start_idx];
-  auto &end_stop = bus_info.route[item.start_idx + item.span_count];
-  for (auto &stop : {start_stop, end_stop}) {
+  auto start_stop = bus_info.route[item.start_idx];
+  auto end_stop = bus_info.route[item.start_idx + item.span_count];
+  for (auto stop : {start_stop, end_stop}) {
     if (std::find(begin(endpoints), end(endpoints), stop) != end(endpoints)) {
-      bus_names.Add(BusName(item.bus, stop_coords_.at(stop),
+      bus_names.Add(BusName(item.bus, stop_coords_[stop],
                             bus_info.color, settings_));
     }
   }
@@ -377,7 +401,7 @@ svg::Section MapRenderer::StopPointsFor(const RouteInfo::RoadItem &item) const {
   svg::SectionBuilder stop_points;
   auto &bus_info = buses_.at(item.bus);
   for (int i = item.start_idx; i <= item.start_idx + item.span_count; ++i) {
-    stop_points.Add(StopPoint(stop_coords_.at(bus_info.route[i]),
+    stop_points.Add(StopPoint(stop_coords_[bus_info.route[i]],
                               settings_.stop_radius));
   }
   return stop_points.Build();
@@ -388,11 +412,13 @@ svg::Section MapRenderer::StopLabelsFor(
   auto &bus_info = buses_.at(item.bus);
   svg::SectionBuilder stop_labels;
   if (first) {
-    auto &deport = bus_info.route[item.start_idx];
-    stop_labels.Add(StopName(deport, stop_coords_.at(deport), settings_));
+    auto deport = bus_info.route[item.start_idx];
+    stop_labels.Add(StopName(stop_names_.GetName(deport),
+                             stop_coords_[deport], settings_));
   }
-  auto &arrival = bus_info.route[item.start_idx + item.span_count];
-  stop_labels.Add(StopName(arrival, stop_coords_.at(arrival), settings_));
+  auto arrival = bus_info.route[item.start_idx + item.span_count];
+  stop_labels.Add(StopName(stop_names_.GetName(arrival),
+                           stop_coords_[arrival], settings_));
   return stop_labels.Build();
 }
 
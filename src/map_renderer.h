@@ -27,25 +27,34 @@ class MapRenderer {
       renderer_utils::Stops stops,
       const RenderingSettings &settings);
 
+  // Whether the coordinates of the stops are in range and the routes are
+  // round trips through their endpoints. Create also checks that the stops
+  // of the routes are given.
+  static bool Validate(const renderer_utils::Buses &buses,
+                       const renderer_utils::Stops &stops);
+
   std::string RenderMap() const;
 
   std::optional<std::string> RenderRoute(const RouteInfo &route_info) const;
 
  private:
+  // The stops are referred to by the ids of stop_names_.
   struct BusInfo {
-    std::vector<std::string> route;
-    std::vector<std::string> endpoints;
+    std::vector<NameId> route;
+    std::vector<NameId> endpoints;
     svg::Color color;
   };
   using Buses = std::unordered_map<std::string, BusInfo>;
 
-  using StopCoords = std::unordered_map<std::string, svg::Point>;
+  // Indexed by the stop ids.
+  using StopCoords = std::vector<svg::Point>;
 
   MapRenderer(const renderer_utils::Buses &buses,
               renderer_utils::Stops stops,
               const RenderingSettings &settings);
 
   static Buses ConstructBuses(const renderer_utils::Buses &buses,
+                              const NameTable &stop_names,
                               const RenderingSettings &settings);
 
   static std::vector<std::string> SortBusNames(const Buses &buses);
@@ -53,7 +62,7 @@ class MapRenderer {
   bool ValidateRoute(const RouteInfo &route_info) const;
 
   static std::vector<svg::Point> Points(
-      const std::vector<std::string> &route,
+      const std::vector<NameId> &route,
       const StopCoords &coords);
 
   static void AddBusLinesLayout(
@@ -70,13 +79,12 @@ class MapRenderer {
 
   static void AddStopPointsLayout(
       svg::SectionBuilder &builder,
-      const renderer_utils::Stops &stops,
       const rm::RenderingSettings &settings,
       const StopCoords &coords);
 
   static void AddStopLabelsLayout(
       svg::SectionBuilder &builder,
-      const renderer_utils::Stops &stops,
+      const NameTable &stop_names,
       const rm::RenderingSettings &settings,
       const StopCoords &coords);
 
@@ -89,6 +97,8 @@ class MapRenderer {
   svg::Section StopLabelsFor(const RouteInfo::RoadItem &item, bool first) const;
 
   svg::Section map_;
+  // The stops are interned in name order, so the ids follow it.
+  NameTable stop_names_;
   Buses buses_;
   StopCoords stop_coords_;
   rm::RenderingSettings settings_;
@@ -0,0 +1,29 @@
+#include "name_table.h"
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace rm {
+NameId NameTable::Intern(std::string_view name) {
+  if (auto it = ids_.find(name); it != ids_.end()) return it->second;
+
+  const auto id = static_cast<NameId>(names_.size());
+  ids_.emplace(names_.emplace_back(name), id);
+  return id;
+}
+
+std::optional<NameId> NameTable::Find(std::string_view name) const {
+  auto it = ids_.find(name);
+  if (it == ids_.end()) return std::nullopt;
+  return it->second;
+}
+
+const std::string &NameTable::GetName(NameId id) const {
+  return names_[id];
+}
+
+size_t NameTable::GetSize() const {
+  return names_.size();
+}
+}
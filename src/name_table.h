@@ -0,0 +1,34 @@
+#ifndef ROOT_MANAGER_SRC_NAME_TABLE_H_
+#define ROOT_MANAGER_SRC_NAME_TABLE_H_
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace rm {
+// Dense id of an interned name: the names of a table get 0, 1, 2... in the
+// order they are interned.
+using NameId = uint32_t;
+
+// Keeps a single copy of every name, so the rest of the manager refers to
+// stops and buses by their ids and resolves the names only for responses.
+class NameTable {
+ public:
+  // Returns the id of `name`, adding it to the table when it's new.
+  NameId Intern(std::string_view name);
+  std::optional<NameId> Find(std::string_view name) const;
+
+  // Stays valid while the table lives, interning doesn't move the names.
+  const std::string &GetName(NameId id) const;
+  size_t GetSize() const;
+
+ private:
+  std::deque<std::string> names_;
+  std::unordered_map<std::string_view, NameId> ids_;
+};
+}
+
+#endif // ROOT_MANAGER_SRC_NAME_TABLE_H_
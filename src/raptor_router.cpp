@@ -0,0 +1,173 @@
+#include "raptor_router.h"
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common.h"
+#include "request_types.h"
+
+namespace {
+constexpr double kNoTime = std::numeric_limits<double>::infinity();
+}
+
+namespace rm {
+RaptorRouter::RaptorRouter(const Base &base,
+                           const RoutingSettings &settings)
+    : bus_wait_time_(settings.bus_wait_time),
+      bus_velocity_(settings.bus_velocity),
+      names_(base.names),
+      stop_buses_(base.stops.GetSize()) {
+  for (NameId bus = 0; bus < base.buses.GetSize(); ++bus) {
+    const auto route = base.buses.GetStops(bus);
+    const auto distances = base.buses.GetRoadDistances(bus);
+    const int stop_count = route.size();
+    for (int idx = 0; idx < stop_count; ++idx) {
+      stop_buses_[route[idx]].push_back({static_cast<int>(bus), idx});
+    }
+    buses_.push_back(Bus{.stops = {route.begin(), route.end()},
+                         .distances = {distances.begin(), distances.end()}});
+  }
+}
+
+void RaptorRouter::UpdateDistances(const Base &base,
+                                   const std::vector<NameId> &buses) {
+  for (auto bus : buses) {
+    const auto distances = base.buses.GetRoadDistances(bus);
+    buses_[bus].distances.assign(distances.begin(), distances.end());
+  }
+}
+
+std::optional<RouteInfo> RaptorRouter::FindRoute(const std::string &from,
+                                                 const std::string &to) const {
+  auto stop_from = names_->stops.Find(from);
+  auto stop_to = names_->stops.Find(to);
+  if (!stop_from || !stop_to)
+    return std::nullopt;
+
+  const auto labels = ScanRounds(*stop_from, *stop_to);
+  if (labels.back()[*stop_to].time == kNoTime) return std::nullopt;
+  return BuildRoute(labels, *stop_to);
+}
+
+std::vector<std::optional<double>> RaptorRouter::FindTimes(
+    const std::string &from,
+    const std::vector<std::string> &targets) const {
+  std::vector<std::optional<double>> times(targets.size());
+  auto stop_from = names_->stops.Find(from);
+  if (!stop_from) return times;
+
+  const auto labels = ScanRounds(*stop_from, std::nullopt);
+  for (size_t i = 0; i < targets.size(); ++i) {
+    auto stop_to = names_->stops.Find(targets[i]);
+    if (!stop_to) continue;
+    const double time = labels.back()[*stop_to].time;
+    if (time != kNoTime) {
+      times[i] = time;
+    }
+  }
+  return times;
+}
+
+std::vector<std::vector<RaptorRouter::Label>> RaptorRouter::ScanRounds(
+    StopId stop_from,
+    std::optional<StopId> stop_to) const {
+  // labels[k][stop] - the fastest arrival at stop with at most k boardings.
+  std::vector<std::vector<Label>> labels;
+  labels.emplace_back(stop_buses_.size(), Label{kNoTime, std::nullopt, 0});
+  labels[0][stop_from].time = 0.0;
+
+  std::vector<StopId> marked_stops = {stop_from};
+  // first_idx[bus] - the first position to scan the bus from, -1 if none.
+  std::vector<int> first_idx(buses_.size(), -1);
+  std::vector<int> queued_buses;
+  for (int round = 1; !marked_stops.empty(); ++round) {
+    for (const StopId stop : marked_stops) {
+      for (auto [bus, idx] : stop_buses_[stop]) {
+        if (first_idx[bus] == -1) queued_buses.push_back(bus);
+        if (first_idx[bus] == -1 || idx < first_idx[bus]) first_idx[bus] = idx;
+      }
+    }
+    marked_stops.clear();
+
+    labels.push_back(labels.back());
+    const auto &prev_labels = labels[round - 1];
+    auto &round_labels = labels[round];
+    for (const int bus_id : queued_buses) {
+      const Bus &bus = buses_[bus_id];
+      std::optional<int> board_idx;
+      // Arrival at the first stop of the bus if it was boarded at board_idx,
+      // which compares boardings at different positions.
+      double board_time = kNoTime;
+      const int stop_count = bus.stops.size();
+      for (int idx = first_idx[bus_id]; idx < stop_count; ++idx) {
+        const StopId stop = bus.stops[idx];
+        if (board_idx) {
+          const double time =
+              prev_labels[bus.stops[*board_idx]].time + bus_wait_time_ +
+                  RideTime(bus, *board_idx, idx);
+          // Routes slower than the best one to the target can't improve it.
+          const double bound =
+              stop_to ? round_labels[*stop_to].time : kNoTime;
+          if (time < std::min(round_labels[stop].time, bound)) {
+            round_labels[stop] = Label{time, Leg{bus_id, *board_idx, idx},
+                                       round};
+            marked_stops.push_back(stop);
+          }
+        }
+        const double prev_time = prev_labels[stop].time;
+        if (prev_time != kNoTime && idx + 1 < stop_count) {
+          const double time = prev_time + bus_wait_time_ -
+              RideTime(bus, 0, idx);
+          if (time < board_time) {
+            board_time = time;
+            board_idx = idx;
+          }
+        }
+      }
+      first_idx[bus_id] = -1;
+    }
+    queued_buses.clear();
+
+    std::sort(marked_stops.begin(), marked_stops.end());
+    marked_stops.erase(std::unique(marked_stops.begin(), marked_stops.end()),
+                       marked_stops.end());
+  }
+  return labels;
+}
+
+double RaptorRouter::RideTime(const Bus &bus,
+                              int board_idx,
+                              int alight_idx) const {
+  return (bus.distances[alight_idx] - bus.distances[board_idx]) /
+      (bus_velocity_ * 1000 / 60);
+}
+
+RouteInfo RaptorRouter::BuildRoute(
+    const std::vector<std::vector<Label>> &labels,
+    StopId to) const {
+  RouteInfo route_info;
+  route_info.time = labels.back()[to].time;
+
+  // Walks the legs back from the target, collecting the items in reverse.
+  const Label *label = &labels.back()[to];
+  while (label->leg) {
+    auto [bus_id, board_idx, alight_idx] = *label->leg;
+    const Bus &bus = buses_[bus_id];
+    route_info.items.emplace_back(RouteInfo::RoadItem{
+        .bus = names_->buses.GetName(bus_id),
+        .time = RideTime(bus, board_idx, alight_idx),
+        .start_idx = board_idx,
+        .span_count = alight_idx - board_idx});
+    route_info.items.emplace_back(RouteInfo::WaitItem{
+        .stop = names_->stops.GetName(bus.stops[board_idx]),
+        .time = bus_wait_time_});
+    label = &labels[label->round - 1][bus.stops[board_idx]];
+  }
+  std::reverse(route_info.items.begin(), route_info.items.end());
+  return route_info;
+}
+}
@@ -0,0 +1,84 @@
+#ifndef ROOT_MANAGER_SRC_RAPTOR_ROUTER_H_
+#define ROOT_MANAGER_SRC_RAPTOR_ROUTER_H_
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "request_types.h"
+
+namespace rm {
+// RaptorRouter searches the bus routes directly in rounds, the k-th round
+// finding the fastest routes with k boardings. Buses run without a
+// timetable: every boarding costs bus_wait_time, so a stop label is the
+// time of arriving there. Needs no precomputation beyond copying the routes.
+class RaptorRouter {
+ public:
+  // Time: O(S+R), Mem: O(S+R), S - number of stops, R - total length of
+  // the bus routes.
+  RaptorRouter(const Base &base, const RoutingSettings &settings);
+
+  // Copies the new route distances of `buses`, whose routes kept their
+  // stops. Time: O(sum(L)), L - length of the route of a bus.
+  void UpdateDistances(const Base &base, const std::vector<NameId> &buses);
+
+  // Time: O(K*(S+R)), Mem: O(K*S), K - number of boardings on the route.
+  std::optional<RouteInfo> FindRoute(const std::string &from,
+                                     const std::string &to) const;
+  // Times of the routes from `from` to each of `targets`, nullopt for the
+  // unreachable and unknown ones. Runs the rounds once for all the targets.
+  // Time: O(K*(S+R)+T), Mem: O(K*S+T), T - number of targets.
+  std::vector<std::optional<double>> FindTimes(
+      const std::string &from,
+      const std::vector<std::string> &targets) const;
+
+ private:
+  using StopId = NameId;
+
+  struct Bus {
+    std::vector<StopId> stops;
+    // distances[idx] - road distance from the first stop to stops[idx].
+    std::vector<double> distances;
+  };
+
+  // Position of a stop in the route of a bus.
+  struct BusStop {
+    int bus;
+    int idx;
+  };
+
+  // Ride that improved the label of a stop.
+  struct Leg {
+    int bus;
+    int board_idx;
+    int alight_idx;
+  };
+
+  struct Label {
+    double time;
+    std::optional<Leg> leg;
+    // Round the label was found in, leg boards with a label of round - 1.
+    int round;
+  };
+
+  // Runs the rounds from `stop_from` until no label improves. Labels that
+  // can't beat the one of `stop_to` aren't kept.
+  std::vector<std::vector<Label>> ScanRounds(
+      StopId stop_from,
+      std::optional<StopId> stop_to) const;
+  double RideTime(const Bus &bus, int board_idx, int alight_idx) const;
+  RouteInfo BuildRoute(const std::vector<std::vector<Label>> &labels,
+                       StopId to) const;
+
+  int bus_wait_time_;
+  double bus_velocity_;
+  std::shared_ptr<const Names> names_;
+  // Indexed by the stop and bus ids.
+  std::vector<std::vector<BusStop>> stop_buses_;
+  std::vector<Bus> buses_;
+};
+}
+
+#endif // ROOT_MANAGER_SRC_RAPTOR_ROUTER_H_
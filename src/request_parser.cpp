@@ -63,6 +63,59 @@ std::vector<rm::MapLayer> AsLayers(const json::Node &node) {
   }
   return layers;
 }
+
+std::optional<rm::RouterType> AsRouterType(const json::Node &node) {
+  if (!node.IsString()) return std::nullopt;
+
+  auto &router = node.AsString();
+  if (router == "floyd_warshall") {
+    return rm::RouterType::kFloydWarshall;
+  } else if (router == "dijkstra") {
+    return rm::RouterType::kDijkstra;
+  } else if (router == "raptor") {
+    return rm::RouterType::kRaptor;
+  } else if (router == "contraction_hierarchy") {
+    return rm::RouterType::kContractionHierarchy;
+  } else if (router == "a_star") {
+    return rm::RouterType::kAStar;
+  } else if (router == "bidirectional_dijkstra") {
+    return rm::RouterType::kBidirectionalDijkstra;
+  } else if (router == "hub_labels") {
+    return rm::RouterType::kHubLabels;
+  } else if (router == "tree_cache") {
+    return rm::RouterType::kTreeCache;
+  } else if (router == "overlay") {
+    return rm::RouterType::kOverlay;
+  }
+  return std::nullopt;
+}
+
+std::optional<rm::GraphModel> AsGraphModel(const json::Node &node) {
+  if (!node.IsString()) return std::nullopt;
+  auto &graph_model = node.AsString();
+  if (graph_model == "pairwise") {
+    return rm::GraphModel::kPairwise;
+  } else if (graph_model == "transit") {
+    return rm::GraphModel::kTransit;
+  }
+  return std::nullopt;
+}
+
+bool IsStopList(const json::Node &node) {
+  return node.IsArray() &&
+      std::all_of(node.AsArray().begin(), node.AsArray().end(), [](auto &item) {
+        return item.IsString();
+      });
+}
+
+std::vector<std::string> AsStopList(json::Node node) {
+  std::vector<std::string> stops;
+  stops.reserve(node.AsArray().size());
+  for (auto &item : node.ReleaseArray()) {
+    stops.push_back(item.ReleaseString());
+  }
+  return stops;
+}
 }
 
 namespace rm {
@@ -78,6 +131,48 @@ std::optional<RoutingSettings> ParseRoutingSettings(json::Dict settings) {
   RoutingSettings rs;
   rs.bus_wait_time = bus_wait_time->second.AsInt();
   rs.bus_velocity = bus_velocity->second.AsDouble();
+
+  if (auto router = settings.find("router"); router != settings.end()) {
+    auto router_type = AsRouterType(router->second);
+    if (!router_type) return std::nullopt;
+    rs.router_type = *router_type;
+  }
+  if (auto threads = settings.find("router_threads");
+      threads != settings.end()) {
+    if (!threads->second.IsInt() || threads->second.AsInt() < 1)
+      return std::nullopt;
+    rs.router_threads = threads->second.AsInt();
+  }
+  if (auto compact = settings.find("router_compact_tables");
+      compact != settings.end()) {
+    if (!compact->second.IsBool()) return std::nullopt;
+    rs.router_compact_tables = compact->second.AsBool();
+  }
+  if (auto fixed_point = settings.find("router_fixed_point_tables");
+      fixed_point != settings.end()) {
+    if (!fixed_point->second.IsBool()) return std::nullopt;
+    rs.router_fixed_point_tables = fixed_point->second.AsBool();
+    if (rs.router_fixed_point_tables && rs.router_compact_tables)
+      return std::nullopt;
+  }
+  if (auto tree_cache_size = settings.find("router_tree_cache_size");
+      tree_cache_size != settings.end()) {
+    if (!tree_cache_size->second.IsInt() ||
+        tree_cache_size->second.AsInt() < 1)
+      return std::nullopt;
+    rs.router_tree_cache_size = tree_cache_size->second.AsInt();
+  }
+  if (auto cache_path = settings.find("router_cache_path");
+      cache_path != settings.end()) {
+    if (!cache_path->second.IsString()) return std::nullopt;
+    rs.router_cache_path = cache_path->second.AsString();
+  }
+  if (auto graph_model = settings.find("graph_model");
+      graph_model != settings.end()) {
+    auto model = AsGraphModel(graph_model->second);
+    if (!model) return std::nullopt;
+    rs.graph_model = *model;
+  }
   return rs;
 }
 
@@ -269,6 +364,8 @@ std::optional<GetRequest> ParseOutputRequest(json::Dict dict) {
     return ParseGetRouteRequest(std::move(dict));
   } else if (request_type == "Map") {
     return ParseGetMapRequest(std::move(dict));
+  } else if (request_type == "RouteMatrix") {
+    return ParseGetRouteMatrixRequest(std::move(dict));
   }
 
   return std::nullopt;
@@ -328,4 +425,27 @@ std::optional<GetMapRequest> ParseGetMapRequest(json::Dict dict) {
 
   return GetMapRequest{.id = id->second.AsInt()};
 }
+
+std::optional<GetRouteMatrixRequest> ParseGetRouteMatrixRequest(
+    json::Dict dict) {
+  auto sources = dict.find("sources");
+  auto targets = dict.find("targets");
+  auto id = dict.find("id");
+  if (sources == dict.end() || targets == dict.end() || id == dict.end())
+    return std::nullopt;
+  if (!IsStopList(sources->second) || !IsStopList(targets->second) ||
+      !id->second.IsInt())
+    return std::nullopt;
+
+  GetRouteMatrixRequest mr;
+  if (auto with_items = dict.find("with_items"); with_items != dict.end()) {
+    if (!with_items->second.IsBool()) return std::nullopt;
+    mr.with_items = with_items->second.AsBool();
+  }
+  mr.sources = AsStopList(std::move(sources->second));
+  mr.targets = AsStopList(std::move(targets->second));
+  mr.id = id->second.AsInt();
+
+  return mr;
+}
 }
@@ -26,6 +26,8 @@ std::optional<GetStopRequest> ParseGetStopRequest(json::Dict request_data);
 std::optional<GetBusRequest> ParseGetBusRequest(json::Dict request_data);
 std::optional<GetRouteRequest> ParseGetRouteRequest(json::Dict request_data);
 std::optional<GetMapRequest> ParseGetMapRequest(json::Dict request_data);
+std::optional<GetRouteMatrixRequest> ParseGetRouteMatrixRequest(
+    json::Dict request_data);
 }
 
 #endif // ROOT_MANAGER_SRC_REQUEST_PARSER_H_
@@ -63,19 +63,9 @@ json::Dict ToJson(std::optional<StopResponse> response, int id) {
   return result;
 }
 
-json::Dict ToJson(std::optional<RouteResponse> response,
-                  std::optional<std::string> map, int id) {
-  json::Dict result;
-
-  result.emplace("request_id", id);
-  if (!response) {
-    result.emplace("error_message", "not found");
-    return result;
-  }
-  result.emplace("total_time", response->time);
-
+json::List ToJson(std::vector<RouteResponse::Item> response_items) {
   json::List items;
-  for (auto &item : response->items) {
+  for (auto &item : response_items) {
     if (std::holds_alternative<RouteResponse::WaitItem>(item)) {
       auto w = std::get<RouteResponse::WaitItem>(item);
       items.emplace_back(json::Dict{
@@ -91,7 +81,20 @@ json::Dict ToJson(std::optional<RouteResponse> response,
           {"span_count", r.span_count}});
     };
   }
-  result.emplace("items", std::move(items));
+  return items;
+}
+
+json::Dict ToJson(std::optional<RouteResponse> response,
+                  std::optional<std::string> map, int id) {
+  json::Dict result;
+
+  result.emplace("request_id", id);
+  if (!response) {
+    result.emplace("error_message", "not found");
+    return result;
+  }
+  result.emplace("total_time", response->time);
+  result.emplace("items", ToJson(std::move(response->items)));
   if (!map.has_value()) {
     result.emplace("error_message", "invalid route info");
   } else {
@@ -104,20 +107,83 @@ json::Dict ToJson(MapResponse resp, int id) {
   return json::Dict{{"request_id", id}, {"map", resp.map}};
 }
 
+json::Dict ToJson(RouteMatrixResponse response, int id) {
+  json::Dict result;
+
+  result.emplace("request_id", id);
+  json::List times;
+  for (auto &row : response.times) {
+    json::List times_row;
+    for (auto time : row) {
+      times_row.push_back(time ? json::Node(*time) : json::Node());
+    }
+    times.emplace_back(std::move(times_row));
+  }
+  result.emplace("times", std::move(times));
+  if (response.routes.empty()) return result;
+
+  json::List items;
+  for (auto &row : response.routes) {
+    json::List items_row;
+    for (auto &route : row) {
+      items_row.push_back(route ? json::Node(ToJson(std::move(route->items)))
+                                : json::Node());
+    }
+    items.emplace_back(std::move(items_row));
+  }
+  result.emplace("items", std::move(items));
+  return result;
+}
+
 std::unique_ptr<Processor> Processor::Create(
     std::vector<PostRequest> requests,
     const RoutingSettings &routing_settings,
     const RenderingSettings &rendering_settings) {
-  auto bus_manager = BusManager::Create(requests, routing_settings);
+  auto bus_manager = BusManager::Create(std::move(requests),
+                                        routing_settings);
   if (!bus_manager) return nullptr;
 
-  auto [buses, stops] = MapRendererParams(requests);
+  auto [buses, stops] = MapRendererParams(bus_manager->GetRequests());
   auto map_renderer = MapRenderer::Create(buses, std::move(stops),
                                           rendering_settings);
   if (!map_renderer) return nullptr;
 
   return std::unique_ptr<Processor>(new Processor(std::move(bus_manager),
-                                                  std::move(map_renderer)));
+                                                  std::move(map_renderer),
+                                                  rendering_settings));
+}
+
+bool Processor::Update(std::vector<PostRequest> requests) {
+  // The stops of the routes are checked by the bus manager.
+  auto [new_buses, new_stops] = MapRendererParams(requests);
+  if (!MapRenderer::Validate(new_buses, new_stops)) return false;
+
+  // The new map is built before the bus manager is updated, so that neither
+  // changes when it can't be built.
+  auto [buses, stops] = MapRendererParams(bus_manager_->GetRequests());
+  bool map_changed = !new_buses.empty();
+  for (auto [stop, coords] : new_stops) {
+    auto it = stops.find(stop);
+    map_changed = map_changed || it == stops.end() ||
+        it->second.latitude != coords.latitude ||
+        it->second.longitude != coords.longitude;
+  }
+  std::unique_ptr<MapRenderer> map_renderer;
+  if (map_changed) {
+    for (auto &[bus, route] : new_buses) {
+      buses.insert_or_assign(bus, std::move(route));
+    }
+    for (auto [stop, coords] : new_stops) {
+      stops.insert_or_assign(stop, coords);
+    }
+    map_renderer = MapRenderer::Create(buses, std::move(stops),
+                                       rendering_settings_);
+    if (!map_renderer) return false;
+  }
+
+  if (!bus_manager_->Update(std::move(requests))) return false;
+  if (map_renderer) map_renderer_ = std::move(map_renderer);
+  return true;
 }
 
 json::List Processor::Process(const std::vector<GetRequest> &requests) const {
@@ -133,9 +199,11 @@ json::List Processor::Process(const std::vector<GetRequest> &requests) const {
 }
 
 Processor::Processor(std::unique_ptr<BusManager> bus_manager,
-                     std::unique_ptr<MapRenderer> map_renderer)
+                     std::unique_ptr<MapRenderer> map_renderer,
+                     const RenderingSettings &rendering_settings)
     : bus_manager_(std::move(bus_manager)),
-      map_renderer_(std::move(map_renderer)) {}
+      map_renderer_(std::move(map_renderer)),
+      rendering_settings_(rendering_settings) {}
 
 json::Dict Processor::Process(const GetBusRequest &request) const {
   return ToJson(bus_manager_->GetBusInfo(request.bus), request.id);
@@ -156,4 +224,10 @@ json::Dict Processor::Process(const GetRouteRequest &request) const {
 json::Dict Processor::Process(const GetMapRequest &request) const {
   return ToJson(MapResponse{.map = map_renderer_->RenderMap()}, request.id);
 }
+
+json::Dict Processor::Process(const GetRouteMatrixRequest &request) const {
+  return ToJson(bus_manager_->GetRouteMatrix(request.sources, request.targets,
+                                             request.with_items),
+                request.id);
+}
 }
@@ -22,6 +22,7 @@ json::List ToJson(std::vector<RouteResponse::Item> response_items);
 json::Dict ToJson(std::optional<RouteResponse> response,
                   std::optional<std::string> map, int id);
 json::Dict ToJson(MapResponse resp, int id);
+json::Dict ToJson(RouteMatrixResponse response, int id);
 
 class Processor {
  public:
@@ -30,19 +31,30 @@ class Processor {
       const RoutingSettings &routing_settings,
       const RenderingSettings &rendering_settings);
 
+  // Applies new and replacing stop and bus requests, see
+  // BusManager::Update. The map is laid out from all the stops and buses at
+  // once, so it's redrawn whole, and only when a stop or a bus is added, a
+  // stop moves or a bus request comes. Returns false and changes nothing when
+  // the updated requests would be invalid. Mustn't run concurrently with
+  // Process.
+  bool Update(std::vector<PostRequest> requests);
+
   json::List Process(const std::vector<GetRequest> &requests) const;
 
  private:
   Processor(std::unique_ptr<BusManager> bus_manager,
-            std::unique_ptr<MapRenderer> map_renderer);
+            std::unique_ptr<MapRenderer> map_renderer,
+            const RenderingSettings &rendering_settings);
 
   json::Dict Process(const GetBusRequest &request) const;
   json::Dict Process(const GetStopRequest &request) const;
   json::Dict Process(const GetRouteRequest &request) const;
   json::Dict Process(const GetMapRequest &request) const;
+  json::Dict Process(const GetRouteMatrixRequest &request) const;
 
   std::unique_ptr<BusManager> bus_manager_;
   std::unique_ptr<MapRenderer> map_renderer_;
+  RenderingSettings rendering_settings_;
 };
 }
 
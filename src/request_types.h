@@ -14,11 +14,64 @@
 #include "sphere.h"
 
 namespace rm {
+enum class RouterType {
+  // Precomputes all-pairs routes, answers queries in O(route size).
+  kFloydWarshall = 0,
+  // Runs a separate search per query, no precomputation.
+  kDijkstra = 1,
+  // Scans the bus routes in rounds per query, one round per boarding. Builds
+  // no graph.
+  kRaptor = 2,
+  // Contracts the graph into a hierarchy at startup, answers queries with two
+  // searches up the hierarchy.
+  kContractionHierarchy = 3,
+  // Runs a separate search per query, led towards the target by the
+  // great-circle distance to it. No precomputation.
+  kAStar = 4,
+  // Runs a search from both ends per query, meeting in the middle. No
+  // precomputation.
+  kBidirectionalDijkstra = 5,
+  // Precomputes the hub labels of all the vertices, answers a query by
+  // merging two of them.
+  kHubLabels = 6,
+  // Runs a search per source on its first query and keeps the most recently
+  // used shortest path trees.
+  kTreeCache = 7,
+  // Splits the graph into nested cells at startup and precomputes the routes
+  // across every cell, answers a query with a search over them.
+  kOverlay = 8,
+};
+
+enum class GraphModel {
+  // An edge for every pair of stops of a bus: O(L^2) edges for L stops.
+  kPairwise = 0,
+  // A ride vertex for every stop of a bus, linked by boarding, riding and
+  // alighting edges: O(L) edges for L stops.
+  kTransit = 1,
+};
+
 struct RoutingSettings {
   // measured in minutes.
   int bus_wait_time;
   // measured in km/h.
   double bus_velocity;
+  RouterType router_type = RouterType::kFloydWarshall;
+  // Threads loading the base requests and precomputing the kFloydWarshall
+  // and kOverlay routes.
+  int router_threads = 1;
+  // Stores the kFloydWarshall tables as float weights and 32-bit edge ids,
+  // using 4 times less memory. Reported times stay exact.
+  bool router_compact_tables = false;
+  // Stores the kFloydWarshall tables as integer thousandths of a minute and
+  // 32-bit edge ids, which are faster to precompute than floats and take as
+  // little memory. Reported times stay exact. Excludes router_compact_tables.
+  bool router_fixed_point_tables = false;
+  // Shortest path trees kept by kTreeCache, each O(number of stops) memory.
+  int router_tree_cache_size = 64;
+  // File with the precomputed kFloydWarshall routes. It is reused when it was
+  // built from the same input and rewritten otherwise. Empty disables it.
+  std::string router_cache_path;
+  GraphModel graph_model = GraphModel::kPairwise;
 };
 
 enum class MapLayer {
@@ -61,6 +114,14 @@ struct GetRouteRequest {
   std::string to;
 };
 
+struct GetRouteMatrixRequest {
+  int id;
+  std::vector<std::string> sources;
+  std::vector<std::string> targets;
+  // Adds the items of every route to the times.
+  bool with_items = false;
+};
+
 struct GetMapRequest {
   int id;
 };
@@ -80,7 +141,7 @@ struct PostStopRequest {
 
 using PostRequest = std::variant<PostBusRequest, PostStopRequest>;
 using GetRequest = std::variant<GetBusRequest, GetStopRequest, GetRouteRequest,
-                                GetMapRequest>;
+                                GetMapRequest, GetRouteMatrixRequest>;
 }
 
 #endif // ROOT_MANAGER_SRC_REQUEST_TYPES_H_
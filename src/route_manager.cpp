@@ -1,29 +1,343 @@
 #include "route_manager.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <variant>
 #include <vector>
 
 #include "common.h"
-#include "distance_computer.h"
 #include "request_types.h"
+#include "router_cache.h"
+#include "shortest_path_tree.h"
+
+namespace {
+enum class EdgeKind : uint8_t {
+  kRoad = 0,
+  kWait = 1,
+  kBoard = 2,
+  kRide = 3,
+  kAlight = 4,
+};
+
+size_t CountVertices(const rm::StopTable &stop_table,
+                     const rm::BusTable &bus_table,
+                     const rm::RoutingSettings &settings) {
+  if (settings.router_type == rm::RouterType::kRaptor) return 0;
+  size_t vertex_count = stop_table.GetSize() * 2;
+  if (settings.graph_model == rm::GraphModel::kTransit) {
+    vertex_count += bus_table.stops.size();
+  }
+  return vertex_count;
+}
+
+// Whether BuildRoute of the router counts the settled vertices.
+template<typename R, typename = void>
+constexpr bool kCountsSettled = false;
+
+template<typename R>
+constexpr bool kCountsSettled<
+    R,
+    std::void_t<decltype(std::declval<const R &>().BuildRoute(
+        graph::VertexId{}, graph::VertexId{},
+        std::declval<std::vector<graph::EdgeId> &>(),
+        std::declval<size_t *>()))>> = true;
+
+// The graph the router searches, if it keeps one.
+template<typename R>
+const graph::CsrGraph<double> *GetSearchGraph(const R &) {
+  return nullptr;
+}
+
+// DijkstraRouter is an AStarRouter too.
+template<typename Weight, typename Heuristic>
+const graph::CsrGraph<Weight> *GetSearchGraph(
+    const graph::AStarRouter<Weight, Heuristic> &router) {
+  return &router.GetGraph();
+}
+
+template<typename Weight>
+const graph::CsrGraph<Weight> *GetSearchGraph(
+    const graph::BidirectionalDijkstraRouter<Weight> &router) {
+  return &router.GetGraph();
+}
+
+// The time of the route, read from the tables of the routers that keep them.
+template<typename R>
+std::optional<double> FindRouteTime(const R &router,
+                                    graph::VertexId from,
+                                    graph::VertexId to,
+                                    std::vector<graph::EdgeId> &route_edges) {
+  return router.BuildRoute(from, to, route_edges);
+}
+
+template<typename Weight, typename StoredWeight, typename StoredEdgeId>
+std::optional<double> FindRouteTime(
+    const graph::Router<Weight, StoredWeight, StoredEdgeId> &router,
+    graph::VertexId from,
+    graph::VertexId to,
+    std::vector<graph::EdgeId> &) {
+  return router.GetWeight(from, to);
+}
+
+// Brings the tables of a router up to date with the new weights of the
+// graph edges. Returns false for the routers that are rebuilt instead.
+template<typename R>
+bool UpdateWeights(R &, const std::vector<graph::EdgeId> &, bool, size_t) {
+  return false;
+}
+
+// A weight increase may lengthen any route, and the tables keep no others,
+// so it takes a rebuild.
+template<typename Weight, typename StoredWeight, typename StoredEdgeId>
+bool UpdateWeights(
+    graph::Router<Weight, StoredWeight, StoredEdgeId> &router,
+    const std::vector<graph::EdgeId> &decreased_edges,
+    bool increased,
+    size_t thread_count) {
+  if (increased) {
+    router.Rebuild(thread_count);
+  } else {
+    for (auto edge_id : decreased_edges) {
+      router.UpdateEdge(edge_id);
+    }
+  }
+  return true;
+}
+
+template<typename Weight>
+bool UpdateWeights(graph::OverlayRouter<Weight> &router,
+                   const std::vector<graph::EdgeId> &,
+                   bool,
+                   size_t thread_count) {
+  router.Customize(thread_count);
+  return true;
+}
+
+template<typename R>
+using StoredWeight =
+    std::remove_const_t<std::remove_pointer_t<
+        decltype(std::declval<const R &>().GetWeights())>>;
+
+template<typename R>
+using StoredEdgeId =
+    std::remove_const_t<std::remove_pointer_t<
+        decltype(std::declval<const R &>().GetPrevEdges())>>;
+
+// Only the Floyd-Warshall routers are cached.
+template<typename R>
+void WriteTables(rm::CacheWriter &, const R &) {}
+
+template<typename Weight, typename StoredWeight, typename StoredEdgeId>
+void WriteTables(
+    rm::CacheWriter &writer,
+    const graph::Router<Weight, StoredWeight, StoredEdgeId> &router) {
+  const uint64_t cell_count = router.GetCellCount();
+  writer.Write(cell_count);
+  writer.WriteArray(router.GetWeights(), cell_count);
+  writer.WriteArray(router.GetPrevEdges(), cell_count);
+}
+
+// Wraps the tables that follow in the cache without copying them.
+template<typename R, typename Graph>
+std::unique_ptr<R> ReadTables(rm::CacheReader &reader, const Graph &graph) {
+  uint64_t cell_count;
+  if (!reader.Read(cell_count)) return nullptr;
+  auto weights = reader.ReadArray<StoredWeight<R>>(cell_count);
+  auto prev_edges = reader.ReadArray<StoredEdgeId<R>>(cell_count);
+  if (!weights || !prev_edges) return nullptr;
+  auto router = std::make_unique<R>(graph, weights, prev_edges);
+  // The tables are laid out by the components of the graph.
+  if (router->GetCellCount() != cell_count || !router->CheckTables())
+    return nullptr;
+  return router;
+}
+}
 
 namespace rm {
-RouteManager::RouteManager(const rm::StopDict &stop_info,
-                           const rm::BusDict &bus_info,
+RouteManager::RouteManager(const rm::Base &base,
                            const rm::RoutingSettings &routing_settings)
-    : settings_(routing_settings),
-      graph_(stop_info.size() * 2),
-      vertices_(stop_info.size() * 2) {
-  ReadStops(stop_info);
-  ReadBuses(bus_info, stop_info);
-  router_ = std::make_unique<Router>(graph_);
+    : graph_(CountVertices(base.stops, base.buses, routing_settings)),
+      names_(base.names),
+      settings_(routing_settings),
+      vertices_(graph_.GetVertexCount()) {
+  if (settings_.router_type == RouterType::kRaptor) {
+    raptor_router_ = std::make_unique<RaptorRouter>(base, settings_);
+    return;
+  }
+
+  // Only the Floyd-Warshall tables are worth caching.
+  std::optional<uint64_t> cache_key;
+  if (settings_.router_type == RouterType::kFloydWarshall &&
+      !settings_.router_cache_path.empty()) {
+    cache_key = ComputeRouterCacheKey(base, settings_);
+    if (LoadRouterCache(base.buses, *cache_key)) return;
+  }
+
+  Build(base.stops, base.buses);
+  if (cache_key) SaveRouterCache(*cache_key);
+}
+
+void RouteManager::Update(const rm::Base &base, const BaseChanges &changes) {
+  if (raptor_router_) {
+    if (changes.routes_changed) {
+      raptor_router_ = std::make_unique<RaptorRouter>(base, settings_);
+    } else {
+      raptor_router_->UpdateDistances(base, changes.buses);
+    }
+    return;
+  }
+
+  if (changes.routes_changed) {
+    graph_ = Graph(CountVertices(base.stops, base.buses, settings_));
+    vertices_.assign(graph_.GetVertexCount(), Vertex{});
+    edges_.clear();
+    Build(base.stops, base.buses);
+    router_cache_.reset();
+    return;
+  }
+
+  // The edges of a bus are contiguous and start with its first road or board
+  // edge. The buses may come in any order when the edges are loaded from the
+  // cache.
+  std::vector<std::optional<graph::EdgeId>> first_edges(base.buses.GetSize());
+  for (graph::EdgeId edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+    std::optional<NameId> bus;
+    if (auto road_edge = std::get_if<RoadEdge>(&edges_[edge_id])) {
+      bus = road_edge->bus;
+    } else if (auto board_edge = std::get_if<BoardEdge>(&edges_[edge_id])) {
+      bus = board_edge->bus;
+    }
+    if (bus && !first_edges[*bus]) first_edges[*bus] = edge_id;
+  }
+  std::vector<graph::EdgeId> decreased_edges;
+  bool increased = false;
+  for (auto bus : changes.buses) {
+    // A bus of less than two stops has no edges.
+    if (!first_edges[bus]) continue;
+    ReweighBus(base.buses, bus, *first_edges[bus], decreased_edges,
+               increased);
+  }
+
+  // The heuristic of kAStar depends on the coordinates too.
+  const bool heuristic_changed =
+      settings_.router_type == RouterType::kAStar && changes.coords_changed;
+  if (decreased_edges.empty() && !increased && !heuristic_changed) return;
+  const bool updated = std::visit([&](auto &router) {
+    return UpdateWeights(*router, decreased_edges, increased,
+                         settings_.router_threads);
+  }, router_);
+  if (!updated) {
+    BuildRouter(base.stops, base.buses);
+  } else {
+    tree_graph_.reset();
+  }
+}
+
+void RouteManager::Build(const rm::StopTable &stop_table,
+                         const rm::BusTable &bus_table) {
+  ReadStops(stop_table);
+  switch (settings_.graph_model) {
+    case GraphModel::kPairwise:
+      ReadBuses(bus_table);
+      break;
+    case GraphModel::kTransit:
+      ReadBusRides(bus_table);
+      break;
+  }
+  BuildRouter(stop_table, bus_table);
+}
+
+void RouteManager::BuildRouter(const rm::StopTable &stop_table,
+                               const rm::BusTable &bus_table) {
+  tree_graph_.reset();
+  switch (settings_.router_type) {
+    case RouterType::kFloydWarshall:
+      if (settings_.router_fixed_point_tables) {
+        router_ = std::make_unique<FixedPointFloydWarshallRouter>(
+            graph_, settings_.router_threads);
+      } else if (settings_.router_compact_tables) {
+        router_ = std::make_unique<CompactFloydWarshallRouter>(
+            graph_, settings_.router_threads);
+      } else {
+        router_ = std::make_unique<FloydWarshallRouter>(
+            graph_, settings_.router_threads);
+      }
+      break;
+    case RouterType::kDijkstra:
+      router_ = std::make_unique<DijkstraRouter>(graph_);
+      break;
+    case RouterType::kContractionHierarchy:
+      router_ = std::make_unique<ContractionHierarchyRouter>(graph_);
+      break;
+    case RouterType::kAStar:
+      router_ = std::make_unique<AStarRouter>(
+          graph_, MakeGeoHeuristic(stop_table, bus_table));
+      break;
+    case RouterType::kBidirectionalDijkstra:
+      router_ = std::make_unique<BidirectionalDijkstraRouter>(graph_);
+      break;
+    case RouterType::kHubLabels:
+      router_ = std::make_unique<HubLabelRouter>(graph_);
+      break;
+    case RouterType::kTreeCache:
+      router_ = std::make_unique<TreeCacheRouter>(
+          graph_, settings_.router_tree_cache_size);
+      break;
+    case RouterType::kOverlay:
+      router_ = std::make_unique<OverlayRouter>(
+          graph_, std::vector<size_t>{64, 1024}, settings_.router_threads);
+      break;
+    case RouterType::kRaptor:
+      break;
+  }
 }
 
-void RouteManager::ReadStops(const rm::StopDict &stop_dict) {
+RouteManager::GeoHeuristic RouteManager::MakeGeoHeuristic(
+    const rm::StopTable &stop_table,
+    const rm::BusTable &bus_table) const {
+  // Every route goes through the bus segments, so the bound holds for a
+  // route when it holds for each segment.
+  double min_ratio = std::numeric_limits<double>::infinity();
+  for (NameId bus = 0; bus < bus_table.GetSize(); ++bus) {
+    const auto road = bus_table.GetRoadDistances(bus);
+    const auto geo = bus_table.GetGeoDistances(bus);
+    for (size_t idx = 1; idx < road.size(); ++idx) {
+      const double geo_distance = geo[idx] - geo[idx - 1];
+      if (geo_distance == 0.0) continue;
+      const double road_distance = road[idx] - road[idx - 1];
+      min_ratio = std::min(min_ratio, road_distance / geo_distance);
+    }
+  }
+
+  if (min_ratio == std::numeric_limits<double>::infinity()) min_ratio = 0.0;
+
+  GeoHeuristic heuristic{
+      .minutes_per_meter = min_ratio / (settings_.bus_velocity * 1000 / 60)};
+  for (auto &vertex : vertices_) {
+    heuristic.coords.push_back(stop_table.GetCoords(vertex));
+  }
+  return heuristic;
+}
+
+double RouteManager::GeoHeuristic::operator()(graph::VertexId from,
+                                              graph::VertexId to) const {
+  return sphere::CalculateDistance(coords[from], coords[to]) *
+      minutes_per_meter;
+}
+
+void RouteManager::ReadStops(const rm::StopTable &stop_table) {
   int vertex_id = 0;
-  for (auto &[stop, _] : stop_dict) {
+  stop_ids_.resize(stop_table.GetSize());
+  for (NameId stop = 0; stop < stop_table.GetSize(); ++stop) {
     auto &[arrive, depart] = stop_ids_[stop];
     arrive = vertex_id++;
     depart = vertex_id++;
@@ -37,16 +351,15 @@ void RouteManager::ReadStops(const rm::StopDict &stop_dict) {
   }
 }
 
-void RouteManager::ReadBuses(const rm::BusDict &bus_dict,
-                             const rm::StopDict &stop_dict) {
-  for (auto &[bus, bus_info] : bus_dict) {
-    auto &route = bus_info.stops;
+void RouteManager::ReadBuses(const rm::BusTable &bus_table) {
+  for (NameId bus = 0; bus < bus_table.GetSize(); ++bus) {
+    const auto route = bus_table.GetStops(bus);
+    const auto distances = bus_table.GetRoadDistances(bus);
     int stop_count = route.size();
     for (int from = 0; from + 1 < stop_count; ++from) {
       const auto depart = stop_ids_[route[from]].depart;
-      double distance = 0.0;
       for (int to = from + 1; to < stop_count; ++to) {
-        distance += ComputeRoadDistance({route[to - 1], route[to]}, stop_dict);
+        const double distance = distances[to] - distances[from];
         edges_.emplace_back(RoadEdge{
             .bus = bus,
             .start_idx = from,
@@ -63,40 +376,391 @@ void RouteManager::ReadBuses(const rm::BusDict &bus_dict,
   }
 }
 
+void RouteManager::ReadBusRides(const rm::BusTable &bus_table) {
+  // Ride vertices follow the arrive and depart vertices of the stops.
+  graph::VertexId ride = stop_ids_.size() * 2;
+  for (NameId bus = 0; bus < bus_table.GetSize(); ++bus) {
+    const auto route = bus_table.GetStops(bus);
+    const auto distances = bus_table.GetRoadDistances(bus);
+    int stop_count = route.size();
+    for (int idx = 0; idx < stop_count; ++idx, ++ride) {
+      const auto &stop_ids = stop_ids_[route[idx]];
+      vertices_[ride] = Vertex{route[idx]};
+      if (idx > 0) {
+        const double distance = distances[idx] - distances[idx - 1];
+        graph_.AddEdge(
+            {
+                .from = ride - 1,
+                .to = ride,
+                .weight = distance / (settings_.bus_velocity * 1000 / 60)
+            });
+        edges_.emplace_back(RideEdge{});
+        graph_.AddEdge({.from = ride, .to = stop_ids.arrive, .weight = 0.0});
+        edges_.emplace_back(AlightEdge{.stop_idx = idx});
+      }
+      if (idx + 1 < stop_count) {
+        graph_.AddEdge({.from = stop_ids.depart, .to = ride, .weight = 0.0});
+        edges_.emplace_back(BoardEdge{.bus = bus, .stop_idx = idx});
+      }
+    }
+  }
+}
+
+void RouteManager::ReweighBus(const rm::BusTable &bus_table,
+                              NameId bus,
+                              graph::EdgeId first_edge,
+                              std::vector<graph::EdgeId> &decreased_edges,
+                              bool &increased) {
+  const auto distances = bus_table.GetRoadDistances(bus);
+  const double meters_per_minute = settings_.bus_velocity * 1000 / 60;
+  graph::EdgeId edge_id = first_edge;
+  auto set_weight = [&](double weight) {
+    const double old_weight = graph_.GetEdge(edge_id).weight;
+    if (weight < old_weight) {
+      decreased_edges.push_back(edge_id);
+    } else if (weight > old_weight) {
+      increased = true;
+    }
+    graph_.SetEdgeWeight(edge_id++, weight);
+  };
+
+  const int stop_count = distances.size();
+  switch (settings_.graph_model) {
+    case GraphModel::kPairwise:
+      for (int from = 0; from + 1 < stop_count; ++from) {
+        for (int to = from + 1; to < stop_count; ++to) {
+          set_weight((distances[to] - distances[from]) / meters_per_minute);
+        }
+      }
+      break;
+    case GraphModel::kTransit:
+      // Only the ride edges have weights, see ReadBusRides.
+      for (int idx = 0; idx < stop_count; ++idx) {
+        if (idx > 0) {
+          set_weight((distances[idx] - distances[idx - 1]) /
+              meters_per_minute);
+          ++edge_id;
+        }
+        if (idx + 1 < stop_count) ++edge_id;
+      }
+      break;
+  }
+}
+
+bool RouteManager::LoadRouterCache(const rm::BusTable &bus_table,
+                                   uint64_t key) {
+  auto file = MappedFile::Create(settings_.router_cache_path);
+  if (!file) return false;
+  CacheReader reader(file->GetData(), file->GetSize());
+  if (!ReadCacheHeader(reader, key)) return false;
+
+  uint64_t vertex_count, edge_count;
+  if (!reader.Read(vertex_count) || !reader.Read(edge_count) ||
+      vertex_count != vertices_.size())
+    return false;
+
+  Graph graph(vertex_count);
+  std::vector<Edge> edges;
+  auto stop_count_of = [&](NameId bus) {
+    return static_cast<int>(bus_table.GetStops(bus).size());
+  };
+  // An alight edge follows the board edge of its bus, see ReadBusRides.
+  std::optional<NameId> board_bus;
+  for (uint64_t i = 0; i < edge_count; ++i) {
+    graph::Edge<double> edge{};
+    EdgeKind kind;
+    if (!reader.Read(edge.from) || !reader.Read(edge.to) ||
+        !reader.Read(edge.weight) || !reader.Read(kind) ||
+        edge.from >= vertex_count || edge.to >= vertex_count)
+      return false;
+    graph.AddEdge(edge);
+
+    switch (kind) {
+      case EdgeKind::kRoad: {
+        RoadEdge road_edge{};
+        if (!ReadBus(reader, road_edge.bus) ||
+            !reader.Read(road_edge.start_idx) ||
+            !reader.Read(road_edge.span_count) ||
+            road_edge.start_idx < 0 || road_edge.span_count <= 0 ||
+            road_edge.span_count >=
+                stop_count_of(road_edge.bus) - road_edge.start_idx)
+          return false;
+        edges.emplace_back(std::move(road_edge));
+        break;
+      }
+      case EdgeKind::kWait:
+        edges.emplace_back(WaitEdge{});
+        break;
+      case EdgeKind::kBoard: {
+        BoardEdge board_edge{};
+        if (!ReadBus(reader, board_edge.bus) ||
+            !reader.Read(board_edge.stop_idx) || board_edge.stop_idx < 0 ||
+            board_edge.stop_idx >= stop_count_of(board_edge.bus))
+          return false;
+        board_bus = board_edge.bus;
+        edges.emplace_back(std::move(board_edge));
+        break;
+      }
+      case EdgeKind::kRide:
+        edges.emplace_back(RideEdge{});
+        break;
+      case EdgeKind::kAlight: {
+        AlightEdge alight_edge{};
+        if (!reader.Read(alight_edge.stop_idx) || !board_bus ||
+            alight_edge.stop_idx < 0 ||
+            alight_edge.stop_idx >= stop_count_of(*board_bus))
+          return false;
+        edges.emplace_back(alight_edge);
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+
+  std::vector<Vertex> vertices(vertex_count);
+  for (auto &vertex : vertices) {
+    if (!ReadStop(reader, vertex)) return false;
+  }
+
+  uint64_t stop_count;
+  if (!reader.Read(stop_count) || stop_count != names_->stops.GetSize())
+    return false;
+  std::vector<StopIds> stop_ids(stop_count);
+  std::vector<bool> has_ids(stop_count);
+  for (uint64_t i = 0; i < stop_count; ++i) {
+    NameId stop;
+    StopIds ids{};
+    if (!ReadStop(reader, stop) || !reader.Read(ids.arrive) ||
+        !reader.Read(ids.depart) || has_ids[stop] ||
+        ids.arrive >= vertex_count || ids.depart >= vertex_count)
+      return false;
+    stop_ids[stop] = ids;
+    has_ids[stop] = true;
+  }
+
+  graph_ = std::move(graph);
+  Router router;
+  if (settings_.router_fixed_point_tables) {
+    router = ReadTables<FixedPointFloydWarshallRouter>(reader, graph_);
+  } else if (settings_.router_compact_tables) {
+    router = ReadTables<CompactFloydWarshallRouter>(reader, graph_);
+  } else {
+    router = ReadTables<FloydWarshallRouter>(reader, graph_);
+  }
+  const bool loaded = std::visit([](auto &r) { return r != nullptr; }, router);
+  if (!loaded || !reader.AtEnd()) {
+    graph_ = Graph(vertex_count);
+    return false;
+  }
+
+  router_cache_ = std::move(file);
+  router_ = std::move(router);
+  edges_ = std::move(edges);
+  vertices_ = std::move(vertices);
+  stop_ids_ = std::move(stop_ids);
+  return true;
+}
+
+bool RouteManager::ReadStop(CacheReader &reader, NameId &stop) const {
+  std::string name;
+  if (!reader.ReadString(name)) return false;
+  auto id = names_->stops.Find(name);
+  if (!id) return false;
+  stop = *id;
+  return true;
+}
+
+bool RouteManager::ReadBus(CacheReader &reader, NameId &bus) const {
+  std::string name;
+  if (!reader.ReadString(name)) return false;
+  auto id = names_->buses.Find(name);
+  if (!id) return false;
+  bus = *id;
+  return true;
+}
+
+void RouteManager::SaveRouterCache(uint64_t key) const {
+  const std::string tmp_path = settings_.router_cache_path + ".tmp";
+  std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+  if (!out) return;
+
+  CacheWriter writer(out);
+  WriteCacheHeader(writer, key);
+  const uint64_t vertex_count = graph_.GetVertexCount();
+  const uint64_t edge_count = graph_.GetEdgeCount();
+  writer.Write(vertex_count);
+  writer.Write(edge_count);
+  for (graph::EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+    auto &edge = graph_.GetEdge(edge_id);
+    writer.Write(edge.from);
+    writer.Write(edge.to);
+    writer.Write(edge.weight);
+    if (auto ptr_r = std::get_if<RoadEdge>(&edges_[edge_id])) {
+      writer.Write(EdgeKind::kRoad);
+      writer.WriteString(names_->buses.GetName(ptr_r->bus));
+      writer.Write(ptr_r->start_idx);
+      writer.Write(ptr_r->span_count);
+    } else if (std::holds_alternative<WaitEdge>(edges_[edge_id])) {
+      writer.Write(EdgeKind::kWait);
+    } else if (auto ptr_b = std::get_if<BoardEdge>(&edges_[edge_id])) {
+      writer.Write(EdgeKind::kBoard);
+      writer.WriteString(names_->buses.GetName(ptr_b->bus));
+      writer.Write(ptr_b->stop_idx);
+    } else if (std::holds_alternative<RideEdge>(edges_[edge_id])) {
+      writer.Write(EdgeKind::kRide);
+    } else if (auto ptr_a = std::get_if<AlightEdge>(&edges_[edge_id])) {
+      writer.Write(EdgeKind::kAlight);
+      writer.Write(ptr_a->stop_idx);
+    }
+  }
+  for (auto vertex : vertices_) {
+    writer.WriteString(names_->stops.GetName(vertex));
+  }
+  writer.Write<uint64_t>(stop_ids_.size());
+  for (NameId stop = 0; stop < stop_ids_.size(); ++stop) {
+    auto &ids = stop_ids_[stop];
+    writer.WriteString(names_->stops.GetName(stop));
+    writer.Write(ids.arrive);
+    writer.Write(ids.depart);
+  }
+  std::visit([&](auto &router) { WriteTables(writer, *router); }, router_);
+
+  out.close();
+  if (!out || std::rename(tmp_path.c_str(),
+                          settings_.router_cache_path.c_str()) != 0) {
+    std::remove(tmp_path.c_str());
+  }
+}
+
 std::optional<RouteInfo> RouteManager::FindRoute(const std::string &from,
-                                                 const std::string &to) {
-  auto it_from = stop_ids_.find(from);
-  auto it_to = stop_ids_.find(to);
-  if (it_from == stop_ids_.end() || it_to == stop_ids_.end())
+                                                 const std::string &to) const {
+  if (raptor_router_) return raptor_router_->FindRoute(from, to);
+
+  auto stop_from = names_->stops.Find(from);
+  auto stop_to = names_->stops.Find(to);
+  if (!stop_from || !stop_to)
     return std::nullopt;
 
-  auto vertex_from = it_from->second.arrive;
-  auto vertex_to = it_to->second.arrive;
-  auto route = router_->BuildRoute(vertex_from, vertex_to);
-  if (!route) return std::nullopt;
+  auto vertex_from = stop_ids_[*stop_from].arrive;
+  auto vertex_to = stop_ids_[*stop_to].arrive;
+  return std::visit([&](const auto &router) {
+    return BuildRoute(*router, vertex_from, vertex_to);
+  }, router_);
+}
+
+std::vector<std::optional<double>> RouteManager::FindRouteTimes(
+    const std::string &from,
+    const std::vector<std::string> &targets) const {
+  if (raptor_router_) return raptor_router_->FindTimes(from, targets);
+
+  std::vector<std::optional<double>> times(targets.size());
+  auto stop_from = names_->stops.Find(from);
+  if (!stop_from) return times;
+  auto vertex_from = stop_ids_[*stop_from].arrive;
+
+  std::shared_ptr<const graph::ShortestPathTree<double>> tree;
+  if (auto ptr_c = std::get_if<std::unique_ptr<TreeCacheRouter>>(&router_)) {
+    tree = (*ptr_c)->GetTree(vertex_from);
+  } else if (auto tree_graph = GetTreeGraph()) {
+    auto built_tree =
+        std::make_shared<graph::ShortestPathTree<double>>(*tree_graph);
+    built_tree->Build(vertex_from);
+    tree = std::move(built_tree);
+  }
+  std::vector<graph::EdgeId> route_edges;
+  for (size_t i = 0; i < targets.size(); ++i) {
+    auto stop_to = names_->stops.Find(targets[i]);
+    if (!stop_to) continue;
+    auto vertex_to = stop_ids_[*stop_to].arrive;
+    if (tree) {
+      times[i] = tree->GetWeight(vertex_to);
+    } else {
+      times[i] = std::visit([&](const auto &router) {
+        return FindRouteTime(*router, vertex_from, vertex_to, route_edges);
+      }, router_);
+    }
+  }
+  return times;
+}
+
+std::optional<TreeCacheStats> RouteManager::GetTreeCacheStats() const {
+  auto ptr_c = std::get_if<std::unique_ptr<TreeCacheRouter>>(&router_);
+  if (!ptr_c) return std::nullopt;
+  return TreeCacheStats{.hit_count = (*ptr_c)->GetHitCount(),
+                        .miss_count = (*ptr_c)->GetMissCount()};
+}
+
+const graph::CsrGraph<double> *RouteManager::GetTreeGraph() const {
+  if (auto graph = std::visit([](const auto &router) {
+    return GetSearchGraph(*router);
+  }, router_)) {
+    return graph;
+  }
+  switch (settings_.router_type) {
+    case RouterType::kContractionHierarchy:
+    case RouterType::kHubLabels:
+    case RouterType::kOverlay:
+      break;
+    default:
+      return nullptr;
+  }
+  std::lock_guard<std::mutex> lock(tree_graph_mutex_);
+  if (!tree_graph_) {
+    tree_graph_ = std::make_unique<graph::CsrGraph<double>>(graph_);
+  }
+  return tree_graph_.get();
+}
+
+template<typename R>
+std::optional<RouteInfo> RouteManager::BuildRoute(const R &router,
+                                                  graph::VertexId from,
+                                                  graph::VertexId to) const {
+  // Reused by the queries of a thread, so they don't allocate the route.
+  thread_local std::vector<graph::EdgeId> route_edges;
+  std::optional<double> weight;
+  size_t settled_count = 0;
+  if constexpr (kCountsSettled<R>) {
+    weight = router.BuildRoute(from, to, route_edges, &settled_count);
+  } else {
+    weight = router.BuildRoute(from, to, route_edges);
+  }
+  if (!weight) return std::nullopt;
 
   RouteInfo route_info;
-  auto route_id = route->id;
-  route_info.time = route->weight;
-  for (int i = 0; i < route->edge_count; ++i) {
-    auto edge_id = router_->GetRouteEdge(route_id, i);
+  route_info.time = *weight;
+  if constexpr (kCountsSettled<R>) {
+    route_info.settled_count = settled_count;
+  }
+  for (auto edge_id : route_edges) {
     auto &edge = graph_.GetEdge(edge_id);
 
     if (auto ptr_r = std::get_if<RoadEdge>(&edges_[edge_id])) {
       route_info.items.emplace_back(RouteInfo::RoadItem{
-          .bus = ptr_r->bus,
+          .bus = names_->buses.GetName(ptr_r->bus),
           .time = edge.weight,
           .start_idx = ptr_r->start_idx,
           .span_count = ptr_r->span_count});
     } else if (std::holds_alternative<WaitEdge>(edges_[edge_id])) {
       route_info.items.emplace_back(RouteInfo::WaitItem{
-          .stop = vertices_[edge.from],
+          .stop = names_->stops.GetName(vertices_[edge.from]),
           .time = static_cast<int>(edge.weight)});
+    } else if (auto ptr_b = std::get_if<BoardEdge>(&edges_[edge_id])) {
+      // The ride and alight edges that follow complete the item.
+      route_info.items.emplace_back(RouteInfo::RoadItem{
+          .bus = names_->buses.GetName(ptr_b->bus),
+          .time = 0.0,
+          .start_idx = ptr_b->stop_idx,
+          .span_count = 0});
+    } else if (std::holds_alternative<RideEdge>(edges_[edge_id])) {
+      std::get<RouteInfo::RoadItem>(route_info.items.back()).time +=
+          edge.weight;
+    } else if (auto ptr_a = std::get_if<AlightEdge>(&edges_[edge_id])) {
+      auto &item = std::get<RouteInfo::RoadItem>(route_info.items.back());
+      item.span_count = ptr_a->stop_idx - item.start_idx;
     }
   }
 
-  router_->ReleaseRoute(route->id);
-
   return route_info;
 }
 }
@@ -2,34 +2,143 @@
 #define ROOT_MANAGER_SRC_ROUTE_MANAGER_H_
 
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
-#include <unordered_map>
 #include <variant>
 #include <vector>
 
+#include "a_star_router.h"
+#include "bidirectional_dijkstra_router.h"
+#include "contraction_hierarchy_router.h"
+#include "csr_graph.h"
+#include "dijkstra_router.h"
+#include "hub_label_router.h"
+#include "overlay_router.h"
+#include "graph.h"
 #include "router.h"
+#include "tree_cache_router.h"
 
+#include "base_reader.h"
 #include "common.h"
+#include "raptor_router.h"
 #include "request_types.h"
+#include "router_cache.h"
+#include "sphere.h"
 
 namespace rm {
+// Queries answered from the trees cached by RouterType::kTreeCache, and the
+// ones that had to build a tree.
+struct TreeCacheStats {
+  size_t hit_count;
+  size_t miss_count;
+};
+
 class RouteManager {
  private:
+  // Lower bound of the route time between two vertices: the great-circle
+  // distance between their stops at the bus velocity, scaled down by the
+  // smallest ratio of road to great-circle distance of a bus segment, so
+  // that it holds when road distances are shorter.
+  struct GeoHeuristic {
+    double operator()(graph::VertexId from, graph::VertexId to) const;
+
+    std::vector<sphere::Coords> coords;
+    double minutes_per_meter;
+  };
+
   using Graph = graph::DirectedWeightedGraph<double>;
-  using Router = graph::Router<double>;
+  using FloydWarshallRouter = graph::Router<double>;
+  using CompactFloydWarshallRouter = graph::CompactRouter<double>;
+  using FixedPointFloydWarshallRouter = graph::FixedPointRouter<double>;
+  using DijkstraRouter = graph::DijkstraRouter<double>;
+  using ContractionHierarchyRouter =
+      graph::ContractionHierarchyRouter<double>;
+  using AStarRouter = graph::AStarRouter<double, GeoHeuristic>;
+  using BidirectionalDijkstraRouter =
+      graph::BidirectionalDijkstraRouter<double>;
+  using HubLabelRouter = graph::HubLabelRouter<double>;
+  using TreeCacheRouter = graph::TreeCacheRouter<double>;
+  using OverlayRouter = graph::OverlayRouter<double>;
+  using Router = std::variant<std::unique_ptr<FloydWarshallRouter>,
+                              std::unique_ptr<CompactFloydWarshallRouter>,
+                              std::unique_ptr<FixedPointFloydWarshallRouter>,
+                              std::unique_ptr<DijkstraRouter>,
+                              std::unique_ptr<ContractionHierarchyRouter>,
+                              std::unique_ptr<AStarRouter>,
+                              std::unique_ptr<BidirectionalDijkstraRouter>,
+                              std::unique_ptr<HubLabelRouter>,
+                              std::unique_ptr<TreeCacheRouter>,
+                              std::unique_ptr<OverlayRouter>>;
 
  public:
-  RouteManager(const rm::StopDict &stop_info,
-               const rm::BusDict &bus_info,
+  RouteManager(const rm::Base &base,
                const rm::RoutingSettings &routing_settings);
 
+  // Brings the routes up to date with `base` after UpdateBase. When the
+  // routes keep their stops, only the edges of the changed buses get new
+  // weights, which the Floyd-Warshall tables take edge by edge and the
+  // overlay cliques by a new customization. Other routers and changes of
+  // the shape of the network rebuild the graph and the router. The router
+  // cache isn't rewritten.
+  void Update(const rm::Base &base, const BaseChanges &changes);
+
+  // Doesn't modify the manager, so it may be called concurrently. The
+  // routers that search per query fill RouteInfo::settled_count.
   std::optional<RouteInfo> FindRoute(const std::string &from,
-                                     const std::string &to);
+                                     const std::string &to) const;
+  // Counted since the router was built, nullopt for the routers other than
+  // RouterType::kTreeCache. Update may rebuild the router, resetting them.
+  std::optional<TreeCacheStats> GetTreeCacheStats() const;
+
+  // Times of the routes from `from` to each of `targets`, nullopt for the
+  // unreachable and unknown stops. Builds no route items, and without
+  // all-pairs tables runs a single search for all the targets.
+  std::vector<std::optional<double>> FindRouteTimes(
+      const std::string &from,
+      const std::vector<std::string> &targets) const;
 
  private:
-  void ReadStops(const rm::StopDict &stop_dict);
-  void ReadBuses(const rm::BusDict &stop_dict, const rm::StopDict &bus_dict);
+  // Builds the graph and the router from the tables.
+  void Build(const rm::StopTable &stop_table, const rm::BusTable &bus_table);
+  void ReadStops(const rm::StopTable &stop_table);
+  // The edge weights are differences of the route distances of the buses.
+  void ReadBuses(const rm::BusTable &bus_table);
+  void ReadBusRides(const rm::BusTable &bus_table);
+  // Sets the weights of the edges of `bus`, which start at `first_edge` and
+  // were added by ReadBuses or ReadBusRides. Collects the edges whose weight
+  // decreased and reports whether any increased.
+  void ReweighBus(const rm::BusTable &bus_table,
+                  NameId bus,
+                  graph::EdgeId first_edge,
+                  std::vector<graph::EdgeId> &decreased_edges,
+                  bool &increased);
+  void BuildRouter(const rm::StopTable &stop_table,
+                   const rm::BusTable &bus_table);
+  GeoHeuristic MakeGeoHeuristic(const rm::StopTable &stop_table,
+                                const rm::BusTable &bus_table) const;
+
+  // Restores the graph, the edge metadata and the router from the cache file
+  // written for `key`. Leaves the manager untouched on failure, including a
+  // damaged file that refers to missing vertices, edges or route stops.
+  bool LoadRouterCache(const rm::BusTable &bus_table, uint64_t key);
+  // Writes the cache file, replacing the old one atomically. Failures are
+  // ignored, the next run just rebuilds the router.
+  void SaveRouterCache(uint64_t key) const;
+  // The cache refers to the stops and buses by name, so it doesn't depend
+  // on the order their ids were assigned in.
+  bool ReadStop(CacheReader &reader, NameId &stop) const;
+  bool ReadBus(CacheReader &reader, NameId &bus) const;
+
+  // The graph FindRouteTimes grows the trees on when router_ has neither
+  // all-pairs tables nor cached trees: the one the router searches, or
+  // tree_graph_. Null for the other routers.
+  const graph::CsrGraph<double> *GetTreeGraph() const;
+
+  template<typename R>
+  std::optional<RouteInfo> BuildRoute(const R &router,
+                                      graph::VertexId from,
+                                      graph::VertexId to) const;
 
   struct StopIds {
     graph::VertexId arrive;
@@ -37,21 +146,43 @@ class RouteManager {
   };
 
   struct RoadEdge {
-    std::string bus;
+    NameId bus;
     int start_idx;
     int span_count;
   };
   struct WaitEdge {};
+  // Edges of GraphModel::kTransit. A route boards a bus at stop_idx, rides
+  // it through ride vertices and alights at another stop_idx.
+  struct BoardEdge {
+    NameId bus;
+    int stop_idx;
+  };
+  struct RideEdge {};
+  struct AlightEdge {
+    int stop_idx;
+  };
 
-  using Edge = std::variant<RoadEdge, WaitEdge>;
-  using Vertex = std::string;
+  using Edge =
+      std::variant<RoadEdge, WaitEdge, BoardEdge, RideEdge, AlightEdge>;
+  // The stop of the vertex.
+  using Vertex = NameId;
 
-  std::unique_ptr<Router> router_;
+  // Holds the router tables when they are loaded from the cache.
+  std::unique_ptr<MappedFile> router_cache_;
+  Router router_;
+  // Copy of the graph FindRouteTimes grows the trees on for the routers
+  // that keep none, built on its first call.
+  mutable std::mutex tree_graph_mutex_;
+  mutable std::unique_ptr<graph::CsrGraph<double>> tree_graph_;
+  // Replaces router_ and the graph for RouterType::kRaptor.
+  std::unique_ptr<RaptorRouter> raptor_router_;
   Graph graph_;
+  std::shared_ptr<const Names> names_;
   rm::RoutingSettings settings_;
   std::vector<Edge> edges_;
   std::vector<Vertex> vertices_;
-  std::unordered_map<std::string, StopIds> stop_ids_;
+  // Indexed by the stop ids.
+  std::vector<StopIds> stop_ids_;
 };
 }
 
@@ -0,0 +1,186 @@
+#include "router_cache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "request_types.h"
+
+namespace {
+// "RMRC" in the file.
+constexpr uint32_t kMagic = 0x43524d52;
+
+// 64-bit FNV-1a.
+class Hasher {
+ public:
+  void Add(const void *data, size_t size) {
+    auto bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i) {
+      hash_ = (hash_ ^ bytes[i]) * 1099511628211ull;
+    }
+  }
+
+  template<typename T>
+  void Add(T value) {
+    Add(&value, sizeof(value));
+  }
+
+  // The size keeps adjacent strings from being read as other strings.
+  void Add(const std::string &str) {
+    Add<uint64_t>(str.size());
+    Add(str.data(), str.size());
+  }
+
+  uint64_t Get() const { return hash_; }
+
+ private:
+  uint64_t hash_ = 14695981039346656037ull;
+};
+
+// Sorts the ids by their names, which unlike the ids don't depend on the
+// order of the requests.
+std::vector<rm::NameId> SortedByName(std::vector<rm::NameId> ids,
+                                     const rm::NameTable &table) {
+  std::sort(ids.begin(), ids.end(), [&](rm::NameId lhs, rm::NameId rhs) {
+    return table.GetName(lhs) < table.GetName(rhs);
+  });
+  return ids;
+}
+
+std::vector<rm::NameId> AllIds(const rm::NameTable &table) {
+  std::vector<rm::NameId> ids(table.GetSize());
+  std::iota(ids.begin(), ids.end(), 0);
+  return ids;
+}
+}
+
+namespace rm {
+uint64_t ComputeRouterCacheKey(const Base &base,
+                               const RoutingSettings &settings) {
+  // The stops and buses are hashed in name order, and refer to each other by
+  // name.
+  auto &stop_names = base.names->stops;
+  auto &bus_names = base.names->buses;
+  Hasher hasher;
+  hasher.Add<uint64_t>(base.stops.GetSize());
+  for (auto stop : SortedByName(AllIds(stop_names), stop_names)) {
+    const auto coords = base.stops.GetCoords(stop);
+    hasher.Add(stop_names.GetName(stop));
+    hasher.Add(coords.latitude);
+    hasher.Add(coords.longitude);
+    const size_t begin = base.stops.dist_offsets[stop];
+    const size_t end = base.stops.dist_offsets[stop + 1];
+    hasher.Add<uint64_t>(end - begin);
+    std::vector<NameId> stops_to(base.stops.dist_stops.begin() + begin,
+                                 base.stops.dist_stops.begin() + end);
+    for (auto stop_to : SortedByName(std::move(stops_to), stop_names)) {
+      hasher.Add(stop_names.GetName(stop_to));
+      hasher.Add(*base.stops.GetRoadDistance(stop, stop_to));
+    }
+  }
+  hasher.Add<uint64_t>(base.buses.GetSize());
+  for (auto bus : SortedByName(AllIds(bus_names), bus_names)) {
+    const auto route = base.buses.GetStops(bus);
+    hasher.Add(bus_names.GetName(bus));
+    hasher.Add<uint64_t>(route.size());
+    for (auto stop : route) {
+      hasher.Add(stop_names.GetName(stop));
+    }
+  }
+  hasher.Add(settings.bus_wait_time);
+  hasher.Add(settings.bus_velocity);
+  hasher.Add(settings.router_compact_tables);
+  hasher.Add(settings.router_fixed_point_tables);
+  hasher.Add(settings.graph_model);
+  return hasher.Get();
+}
+
+CacheWriter::CacheWriter(std::ostream &out) : out_(out) {}
+
+void CacheWriter::WriteString(const std::string &str) {
+  Write<uint64_t>(str.size());
+  WriteBytes(str.data(), str.size());
+}
+
+void CacheWriter::WriteBytes(const void *data, size_t size) {
+  out_.write(static_cast<const char *>(data), size);
+  offset_ += size;
+}
+
+CacheReader::CacheReader(const char *data, size_t size)
+    : data_(data), size_(size) {}
+
+bool CacheReader::ReadString(std::string &str) {
+  uint64_t size;
+  if (!Read(size) || size > size_ - offset_) return false;
+  str.assign(data_ + offset_, size);
+  offset_ += size;
+  return true;
+}
+
+bool CacheReader::AtEnd() const {
+  return offset_ == size_;
+}
+
+bool CacheReader::Skip(size_t size) {
+  if (size > size_ - offset_) return false;
+  offset_ += size;
+  return true;
+}
+
+void WriteCacheHeader(CacheWriter &writer, uint64_t key) {
+  writer.Write(kMagic);
+  writer.Write(kRouterCacheVersion);
+  writer.Write(key);
+}
+
+bool ReadCacheHeader(CacheReader &reader, uint64_t key) {
+  uint32_t magic, version;
+  uint64_t file_key;
+  return reader.Read(magic) && magic == kMagic &&
+      reader.Read(version) && version == kRouterCacheVersion &&
+      reader.Read(file_key) && file_key == key;
+}
+
+std::unique_ptr<MappedFile> MappedFile::Create(const std::string &path) {
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1) return nullptr;
+
+  struct stat file_stat{};
+  void *data = MAP_FAILED;
+  if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+    data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  // The mapping stays valid after the descriptor is closed.
+  close(fd);
+  if (data == MAP_FAILED) return nullptr;
+
+  return std::unique_ptr<MappedFile>(new MappedFile(data, file_stat.st_size));
+}
+
+MappedFile::MappedFile(void *data, size_t size) : data_(data), size_(size) {}
+
+MappedFile::~MappedFile() {
+  munmap(data_, size_);
+}
+
+const char *MappedFile::GetData() const {
+  return static_cast<const char *>(data_);
+}
+
+size_t MappedFile::GetSize() const {
+  return size_;
+}
+}
@@ -0,0 +1,133 @@
+#ifndef ROOT_MANAGER_SRC_ROUTER_CACHE_H_
+#define ROOT_MANAGER_SRC_ROUTER_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+#include "common.h"
+#include "request_types.h"
+
+// Building blocks of the router cache: a binary file with the precomputed
+// route tables, which later runs map read-only instead of recomputing them.
+namespace rm {
+// Bump on every change of the file layout.
+inline constexpr uint32_t kRouterCacheVersion = 3;
+// Arrays start at this offset alignment, which covers SIMD loads and cache
+// lines.
+inline constexpr size_t kArrayAlignment = 64;
+
+// Hash of everything the precomputed routes depend on. The file is reused only
+// when it was written for the same key.
+uint64_t ComputeRouterCacheKey(const Base &base,
+                               const RoutingSettings &settings);
+
+// Appends values to a cache file in the native byte order.
+class CacheWriter {
+ public:
+  explicit CacheWriter(std::ostream &out);
+
+  template<typename T>
+  void Write(const T &value);
+  void WriteString(const std::string &str);
+  // Aligns the array to kArrayAlignment, so that it can be used in place once
+  // the file is mapped.
+  template<typename T>
+  void WriteArray(const T *data, size_t count);
+
+ private:
+  void WriteBytes(const void *data, size_t size);
+
+  std::ostream &out_;
+  size_t offset_ = 0;
+};
+
+// Reads values written by CacheWriter. Every method returns false or nullptr
+// if the data ends too early.
+class CacheReader {
+ public:
+  CacheReader(const char *data, size_t size);
+
+  template<typename T>
+  bool Read(T &value);
+  bool ReadString(std::string &str);
+  // Returns a pointer into the data, which must be aligned to
+  // kArrayAlignment.
+  template<typename T>
+  const T *ReadArray(size_t count);
+
+  bool AtEnd() const;
+
+ private:
+  bool Skip(size_t size);
+
+  const char *data_;
+  size_t size_;
+  size_t offset_ = 0;
+};
+
+// Writes and checks the magic number, kRouterCacheVersion and the key.
+void WriteCacheHeader(CacheWriter &writer, uint64_t key);
+bool ReadCacheHeader(CacheReader &reader, uint64_t key);
+
+// Whole file mapped read-only into memory.
+class MappedFile {
+ public:
+  // Returns nullptr if the file can't be opened or mapped.
+  static std::unique_ptr<MappedFile> Create(const std::string &path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  const char *GetData() const;
+  size_t GetSize() const;
+
+ private:
+  MappedFile(void *data, size_t size);
+
+  void *data_;
+  size_t size_;
+};
+
+template<typename T>
+void CacheWriter::Write(const T &value) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  WriteBytes(&value, sizeof(T));
+}
+
+template<typename T>
+void CacheWriter::WriteArray(const T *data, size_t count) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  static const char kPadding[kArrayAlignment] = {};
+  WriteBytes(kPadding, (kArrayAlignment - offset_ % kArrayAlignment)
+      % kArrayAlignment);
+  WriteBytes(data, count * sizeof(T));
+}
+
+template<typename T>
+bool CacheReader::Read(T &value) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  const size_t offset = offset_;
+  if (!Skip(sizeof(T))) return false;
+  std::memcpy(&value, data_ + offset, sizeof(T));
+  return true;
+}
+
+template<typename T>
+const T *CacheReader::ReadArray(size_t count) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  if (!Skip((kArrayAlignment - offset_ % kArrayAlignment) % kArrayAlignment))
+    return nullptr;
+  if (count > (size_ - offset_) / sizeof(T)) return nullptr;
+  const size_t offset = offset_;
+  Skip(count * sizeof(T));
+  return reinterpret_cast<const T *>(data_ + offset);
+}
+}
+
+#endif // ROOT_MANAGER_SRC_ROUTER_CACHE_H_
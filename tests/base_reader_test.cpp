@@ -0,0 +1,202 @@
+#include "src/base_reader.h"
+
+#include <algorithm>
+#include <optional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common.h"
+#include "src/request_types.h"
+#include "src/sphere.h"
+#include "test_utils.h"
+
+using namespace std;
+
+TEST(TestBaseReader, TestReadBase) {
+  const auto base = rm::ReadBase({
+      rm::PostBusRequest{.bus = "loop", .stops = {"A", "B", "C", "A"}},
+      rm::PostStopRequest{.stop = "A", .coords = {55.61, 37.20},
+          .stop_distances = {{"B", 3000}}},
+      rm::PostStopRequest{.stop = "B", .coords = {55.59, 37.21},
+          .stop_distances = {{"A", 2500}}},
+      rm::PostStopRequest{.stop = "C", .coords = {55.58, 37.23},
+          .stop_distances = {{"A", 4000}}},
+      rm::PostBusRequest{.bus = "line", .stops = {"B", "A"}},
+  });
+  auto &stops = base.names->stops;
+  auto &buses = base.names->buses;
+  ASSERT_EQ(3, stops.GetSize());
+  ASSERT_EQ(2, buses.GetSize());
+  EXPECT_EQ("A", stops.GetName(0));
+  EXPECT_EQ("C", stops.GetName(2));
+  EXPECT_EQ("loop", buses.GetName(0));
+  EXPECT_EQ("line", buses.GetName(1));
+
+  const rm::NameId a = 0, b = 1, c = 2;
+  auto &stop_table = base.stops;
+  EXPECT_EQ(optional<int>(3000), stop_table.GetRoadDistance(a, b));
+  EXPECT_EQ(optional<int>(4000), stop_table.GetRoadDistance(a, c))
+            << "The distance back defaults to the one of C";
+  EXPECT_EQ(optional<int>(2500), stop_table.GetRoadDistance(b, a));
+  EXPECT_EQ(nullopt, stop_table.GetRoadDistance(b, c));
+  EXPECT_EQ(nullopt, stop_table.GetRoadDistance(c, b));
+  EXPECT_EQ(nullopt, stop_table.GetRoadDistance(a, a));
+  EXPECT_DOUBLE_EQ(55.59 * 3.1415926535 / 180,
+                   stop_table.GetCoords(b).latitude);
+
+  auto buses_of = [&](rm::NameId stop) {
+    auto buses = stop_table.GetBuses(stop);
+    return vector<rm::NameId>(buses.begin(), buses.end());
+  };
+  EXPECT_EQ((vector<rm::NameId>{1, 0}), buses_of(a)) << "Sorted by name";
+  EXPECT_EQ((vector<rm::NameId>{0}), buses_of(c));
+
+  auto &bus_table = base.buses;
+  auto route = bus_table.GetStops(0);
+  EXPECT_EQ((vector<rm::NameId>{a, b, c, a}),
+            vector<rm::NameId>(route.begin(), route.end()));
+  EXPECT_EQ(3, bus_table.unique_stop_counts[0]);
+  const double geo_bc = rm::sphere::CalculateDistance(
+      stop_table.GetCoords(b), stop_table.GetCoords(c));
+  const auto road = bus_table.GetRoadDistances(0);
+  ASSERT_EQ(4, road.size());
+  EXPECT_DOUBLE_EQ(0, road[0]);
+  EXPECT_DOUBLE_EQ(3000, road[1]);
+  EXPECT_DOUBLE_EQ(3000 + geo_bc, road[2]) << "No road distance from B to C";
+  EXPECT_DOUBLE_EQ(7000 + geo_bc, road[3]);
+  const auto geo = bus_table.GetGeoDistances(0);
+  ASSERT_EQ(4, geo.size());
+  EXPECT_DOUBLE_EQ(0, geo[0]);
+  EXPECT_DOUBLE_EQ(geo[1] + geo_bc, geo[2]);
+  EXPECT_DOUBLE_EQ(road.back() / geo.back(), bus_table.curvatures[0]);
+
+  EXPECT_EQ(2, bus_table.GetStops(1).size());
+  EXPECT_DOUBLE_EQ(2500, bus_table.GetRoadDistances(1).back());
+}
+
+namespace {
+// Requests of the stops "stop0"... and the buses "bus0"..., in this order.
+vector<rm::PostRequest> RandomRequests(mt19937 &gen, int stop_count,
+                                       int bus_count) {
+  uniform_int_distribution<int> stop(0, stop_count - 1);
+  uniform_int_distribution<int> distance(100, 5000);
+  uniform_real_distribution<double> coord(55.0, 56.0);
+
+  vector<rm::PostRequest> requests;
+  for (int i = 0; i < stop_count; ++i) {
+    rm::PostStopRequest request{.stop = "stop" + to_string(i),
+                                .coords = {coord(gen), coord(gen)}};
+    for (int j = 0; j < 3; ++j) {
+      request.stop_distances["stop" + to_string(stop(gen))] = distance(gen);
+    }
+    requests.emplace_back(std::move(request));
+  }
+  for (int i = 0; i < bus_count; ++i) {
+    rm::PostBusRequest request{.bus = "bus" + to_string(i)};
+    for (int j = 0; j < 20; ++j) {
+      request.stops.push_back("stop" + to_string(stop(gen)));
+    }
+    requests.emplace_back(std::move(request));
+  }
+  return requests;
+}
+
+const string &GetName(const rm::PostRequest &request) {
+  if (auto bus = get_if<rm::PostBusRequest>(&request)) return bus->bus;
+  return get<rm::PostStopRequest>(request).stop;
+}
+
+void ExpectSameTables(const rm::Base &want, const rm::Base &got) {
+  EXPECT_EQ(want.stops.latitudes, got.stops.latitudes);
+  EXPECT_EQ(want.stops.longitudes, got.stops.longitudes);
+  EXPECT_EQ(want.stops.dist_offsets, got.stops.dist_offsets);
+  EXPECT_EQ(want.stops.dist_stops, got.stops.dist_stops);
+  EXPECT_EQ(want.stops.dists, got.stops.dists);
+  EXPECT_EQ(want.stops.bus_offsets, got.stops.bus_offsets);
+  EXPECT_EQ(want.stops.buses, got.stops.buses);
+  EXPECT_EQ(want.buses.stop_offsets, got.buses.stop_offsets);
+  EXPECT_EQ(want.buses.stops, got.buses.stops);
+  EXPECT_EQ(want.buses.road_distances, got.buses.road_distances);
+  EXPECT_EQ(want.buses.geo_distances, got.buses.geo_distances);
+  EXPECT_EQ(want.buses.unique_stop_counts, got.buses.unique_stop_counts);
+  EXPECT_EQ(want.buses.curvatures, got.buses.curvatures);
+}
+}
+
+TEST(TestBaseReader, TestThreadCount) {
+  mt19937 gen(17);
+  const auto requests = RandomRequests(gen, 300, 100);
+  const auto want = rm::ReadBase(requests);
+  for (size_t thread_count : {2, 4}) {
+    rm::IngestionTimes times;
+    ExpectSameTables(want, rm::ReadBase(requests, thread_count, &times));
+  }
+}
+
+TEST(TestBaseReader, TestUpdateBase) {
+  mt19937 gen(29);
+  auto requests = RandomRequests(gen, 300, 100);
+  auto base = rm::ReadBase(requests);
+  int stop_count = 300, bus_count = 100;
+
+  for (int round = 0; round < 20; ++round) {
+    auto updates = RandomRequests(gen, stop_count, bus_count);
+    uniform_int_distribution<int> pick(0, 7);
+    vector<rm::PostRequest> round_updates;
+    for (auto &update : updates) {
+      if (pick(gen) == 0) round_updates.push_back(std::move(update));
+    }
+    // Keeps the routes of some buses and the coordinates of some stops, so
+    // that only their distances change.
+    for (auto &update : round_updates) {
+      if (pick(gen) > 1) continue;
+      auto &request = *find_if(requests.begin(), requests.end(),
+                               [&](auto &request) {
+                                 return request.index() == update.index() &&
+                                     GetName(request) == GetName(update);
+                               });
+      if (auto bus = get_if<rm::PostBusRequest>(&update)) {
+        bus->stops = get<rm::PostBusRequest>(request).stops;
+      } else {
+        get<rm::PostStopRequest>(update).coords =
+            get<rm::PostStopRequest>(request).coords;
+      }
+    }
+    if (round % 5 == 4) {
+      auto extra = RandomRequests(gen, stop_count + 2, bus_count + 1);
+      round_updates.push_back(extra[stop_count]);
+      round_updates.push_back(extra[stop_count + 1]);
+      round_updates.push_back(extra.back());
+    }
+
+    // The requests ReadBase gets: the replaced ones in place, the new ones
+    // last.
+    auto merged = requests;
+    for (auto &update : round_updates) {
+      bool replaced = false;
+      for (auto &request : merged) {
+        if (request.index() == update.index() &&
+            GetName(request) == GetName(update)) {
+          request = update;
+          replaced = true;
+        }
+      }
+      if (!replaced) merged.push_back(update);
+    }
+
+    const auto changes = rm::UpdateBase(round_updates, requests, base);
+    ASSERT_EQ(merged.size(), requests.size()) << round;
+    const auto want = rm::ReadBase(merged);
+    ASSERT_EQ(want.names->stops.GetSize(), base.names->stops.GetSize());
+    ASSERT_EQ(want.names->buses.GetSize(), base.names->buses.GetSize());
+    ExpectSameTables(want, base);
+    EXPECT_EQ(round % 5 == 4, changes.routes_changed &&
+        base.stops.GetSize() > static_cast<size_t>(stop_count)) << round;
+    stop_count = base.stops.GetSize();
+    bus_count = base.buses.GetSize();
+  }
+}
@@ -1,7 +1,11 @@
 #include "src/bus_manager.h"
 
+#include <algorithm>
+#include <filesystem>
 #include <optional>
+#include <random>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -15,6 +19,56 @@ const rm::RoutingSettings kTestRoutingSettings{
     .bus_velocity = 54.0
 };
 
+struct RouterConfig {
+  rm::RouterType router_type;
+  bool compact_tables;
+  rm::GraphModel graph_model;
+  bool fixed_point_tables = false;
+};
+
+// Routing engines checked against the same expected routes. Only the first
+// one breaks ties between equal-time routes like the expectations do.
+const RouterConfig kRouterConfigs[] = {
+    {rm::RouterType::kFloydWarshall, false, rm::GraphModel::kPairwise},
+    {rm::RouterType::kFloydWarshall, true, rm::GraphModel::kPairwise},
+    {rm::RouterType::kFloydWarshall, false, rm::GraphModel::kPairwise, true},
+    {rm::RouterType::kDijkstra, false, rm::GraphModel::kPairwise},
+    {rm::RouterType::kFloydWarshall, false, rm::GraphModel::kTransit},
+    {rm::RouterType::kDijkstra, false, rm::GraphModel::kTransit},
+    {rm::RouterType::kRaptor, false, rm::GraphModel::kPairwise},
+    {rm::RouterType::kContractionHierarchy, false, rm::GraphModel::kPairwise},
+    {rm::RouterType::kContractionHierarchy, false, rm::GraphModel::kTransit},
+    {rm::RouterType::kAStar, false, rm::GraphModel::kPairwise},
+    {rm::RouterType::kAStar, false, rm::GraphModel::kTransit},
+    {rm::RouterType::kBidirectionalDijkstra, false, rm::GraphModel::kPairwise},
+    {rm::RouterType::kBidirectionalDijkstra, false, rm::GraphModel::kTransit},
+    {rm::RouterType::kHubLabels, false, rm::GraphModel::kPairwise},
+    {rm::RouterType::kHubLabels, false, rm::GraphModel::kTransit},
+    {rm::RouterType::kTreeCache, false, rm::GraphModel::kPairwise},
+    {rm::RouterType::kTreeCache, false, rm::GraphModel::kTransit},
+    {rm::RouterType::kOverlay, false, rm::GraphModel::kPairwise},
+    {rm::RouterType::kOverlay, false, rm::GraphModel::kTransit},
+};
+
+// Checks that every ride follows a wait and that the items add up to the
+// total time.
+void ExpectConsistentRoute(const rm::RouteResponse &route,
+                           const std::string &name) {
+  double time = 0;
+  for (size_t i = 0; i < route.items.size(); ++i) {
+    if (auto wait = get_if<rm::RouteResponse::WaitItem>(&route.items[i])) {
+      time += wait->time;
+    } else {
+      auto &ride = get<rm::RouteResponse::RoadItem>(route.items[i]);
+      EXPECT_TRUE(i > 0 && holds_alternative<rm::RouteResponse::WaitItem>(
+          route.items[i - 1])) << name;
+      EXPECT_GT(ride.span_count, 0) << name;
+      time += ride.time;
+    }
+  }
+  EXPECT_TRUE(rm::CompareLength(route.time, time, 9)) << name;
+}
+
 TEST(TestFactoryMethod, TestInitializing) {
   using namespace rm;
 
@@ -418,7 +472,7 @@ TEST(TestBusManager, TestGetStopInfo) {
     vector<PostRequest> config;
     RoutingSettings routing_settings;
     vector<GetStopRequest> requests;
-    vector<optional<StopInfo>> want;
+    vector<optional<StopResponse>> want;
   };
 
   vector<TestCase> test_cases{
@@ -476,9 +530,9 @@ TEST(TestBusManager, TestGetStopInfo) {
                        GetStopRequest{.stop = "stop8"},
                        GetStopRequest{.stop = "stop10"}},
           .want = {
-              StopInfo{.buses = {"Bus1"}},
-              StopInfo{.buses = {"Bus1", "Bus2"}},
-              StopInfo{},
+              StopResponse{.buses = {"Bus1"}},
+              StopResponse{.buses = {"Bus1", "Bus2"}},
+              StopResponse{},
               nullopt},
       },
   };
@@ -701,17 +755,231 @@ TEST(TestBusManager, TestFindRouteInfo) {
   };
 
   for (auto &[name, config, routing_settings, requests, want] : test_cases) {
-    auto bm = BusManager::Create(std::move(config), routing_settings);
-    EXPECT_TRUE(bm) << name;
-    if (!bm) continue;
+    for (auto &router_config : kRouterConfigs) {
+      routing_settings.router_type = router_config.router_type;
+      routing_settings.router_compact_tables = router_config.compact_tables;
+      routing_settings.router_fixed_point_tables =
+          router_config.fixed_point_tables;
+      routing_settings.graph_model = router_config.graph_model;
+      auto bm = BusManager::Create(config, routing_settings);
+      EXPECT_TRUE(bm) << name;
+      if (!bm) continue;
+
+      for (int i = 0; i < requests.size(); ++i) {
+        auto got = bm->GetRoute(requests[i].from, requests[i].to);
+
+        EXPECT_EQ(want[i].has_value(), got.has_value()) << name;
+        if (!got || !want[i]) continue;
+
+        const auto type = router_config.router_type;
+        const bool counts_settled =
+            type == rm::RouterType::kDijkstra ||
+            type == rm::RouterType::kAStar ||
+            type == rm::RouterType::kBidirectionalDijkstra ||
+            type == rm::RouterType::kOverlay;
+        EXPECT_EQ(counts_settled, got->settled_count.has_value()) << name;
+        if (got->settled_count) {
+          EXPECT_GT(*got->settled_count, 0) << name;
+        }
+
+        if (&router_config == &kRouterConfigs[0]) {
+          EXPECT_EQ(want[i], got) << name;
+        } else {
+          EXPECT_TRUE(CompareLength(want[i]->time, got->time, 9)) << name;
+          ExpectConsistentRoute(*got, name);
+        }
+      }
 
-    for (int i = 0; i < requests.size(); ++i) {
-      auto got = bm->GetRoute(requests[i].from, requests[i].to);
+      // The matrix must agree with the separate requests.
+      vector<string> sources, targets;
+      for (auto &request : requests) {
+        sources.push_back(request.from);
+        targets.push_back(request.to);
+      }
+      auto matrix = bm->GetRouteMatrix(sources, targets, true);
+      ASSERT_EQ(sources.size(), matrix.times.size()) << name;
+      ASSERT_EQ(sources.size(), matrix.routes.size()) << name;
+      for (size_t i = 0; i < sources.size(); ++i) {
+        ASSERT_EQ(targets.size(), matrix.times[i].size()) << name;
+        for (size_t j = 0; j < targets.size(); ++j) {
+          auto route = bm->GetRoute(sources[i], targets[j]);
+          auto &time = matrix.times[i][j];
+          EXPECT_EQ(route.has_value(), time.has_value()) << name;
+          if (route && time) {
+            EXPECT_TRUE(CompareLength(route->time, *time, 9)) << name;
+          }
+          EXPECT_EQ(route, matrix.routes[i][j]) << name;
+        }
+      }
+    }
+  }
+}
 
-      EXPECT_EQ(want[i].has_value(), got.has_value()) << name;
-      if (!got || !want[i]) continue;
+TEST(TestBusManager, TestTreeCacheStats) {
+  using namespace rm;
+
+  const vector<PostRequest> config = {
+      PostBusRequest{.bus = "Bus1", .stops = {"stop1", "stop2", "stop1"}},
+      PostStopRequest{.stop = "stop1", .coords = {55.57, 37.65},
+          .stop_distances = {{"stop2", 2600}}},
+      PostStopRequest{.stop = "stop2", .coords = {55.59, 37.65}},
+  };
+  auto routing_settings = kTestRoutingSettings;
+  routing_settings.router_type = RouterType::kTreeCache;
+  auto bm = BusManager::Create(config, routing_settings);
+  ASSERT_TRUE(bm);
+
+  auto expect_stats = [&](size_t hit_count, size_t miss_count) {
+    auto stats = bm->GetTreeCacheStats();
+    ASSERT_TRUE(stats);
+    EXPECT_EQ(hit_count, stats->hit_count);
+    EXPECT_EQ(miss_count, stats->miss_count);
+  };
+  expect_stats(0, 0);
+  bm->GetRoute("stop1", "stop2");
+  expect_stats(0, 1);
+  bm->GetRoute("stop1", "stop1");
+  expect_stats(1, 1);
+  bm->GetRoute("stop2", "stop1");
+  expect_stats(1, 2);
+
+  routing_settings.router_type = RouterType::kDijkstra;
+  EXPECT_FALSE(BusManager::Create(config, routing_settings)
+                   ->GetTreeCacheStats());
+}
+
+TEST(TestBusManager, TestUpdate) {
+  using namespace rm;
 
-      EXPECT_EQ(want[i], got) << name;
+  const int stop_count = 20, bus_count = 6;
+  mt19937 gen(23);
+  uniform_int_distribution<int> stop(0, stop_count - 1);
+  uniform_int_distribution<int> distance(500, 5000);
+  uniform_real_distribution<double> coord(55.5, 55.8);
+  auto stop_name = [](int i) { return "stop" + to_string(i); };
+  auto random_stop = [&](int i) {
+    PostStopRequest request{.stop = stop_name(i),
+                            .coords = {coord(gen), coord(gen)}};
+    for (int j = 0; j < 4; ++j) {
+      request.stop_distances[stop_name(stop(gen))] = distance(gen);
+    }
+    return request;
+  };
+  auto random_bus = [&](const string &bus) {
+    PostBusRequest request{.bus = bus};
+    for (int j = 0; j < 6; ++j) {
+      request.stops.push_back(stop_name(stop(gen)));
     }
+    request.stops.push_back(request.stops.front());
+    return request;
+  };
+
+  vector<PostRequest> config;
+  for (int i = 0; i < stop_count; ++i) {
+    config.emplace_back(random_stop(i));
+  }
+  for (int i = 0; i < bus_count; ++i) {
+    config.emplace_back(random_bus("bus" + to_string(i)));
   }
+
+  // Changes of the first segments of bus0.
+  auto &route = get<PostBusRequest>(config[stop_count]).stops;
+  auto get_stop = [&](const string &name) {
+    return get<PostStopRequest>(config[stoi(name.substr(4))]);
+  };
+  auto shorter = get_stop(route[0]);
+  shorter.stop_distances[route[1]] = 100;
+  auto longer = shorter;
+  longer.stop_distances[route[1]] = 20000;
+  auto moved = get_stop(route[2]);
+  moved.coords.latitude += 0.05;
+  moved.stop_distances.clear();
+  auto new_stop = random_stop(stop_count);
+  new_stop.stop_distances[stop_name(7)] = 300;
+  auto new_bus = random_bus("bus" + to_string(bus_count));
+  new_bus.stops.insert(new_bus.stops.begin() + 1, stop_name(stop_count));
+
+  const vector<pair<string, vector<PostRequest>>> updates = {
+      {"Shorter distances", {shorter}},
+      {"Longer distances", {longer}},
+      {"Moved stop", {moved}},
+      {"Same route", {get<PostBusRequest>(config[stop_count])}},
+      {"Other route", {random_bus("bus1")}},
+      {"New stop and bus", {new_bus, new_stop}},
+  };
+
+  for (auto &router_config : kRouterConfigs) {
+    auto routing_settings = kTestRoutingSettings;
+    routing_settings.router_type = router_config.router_type;
+    routing_settings.router_compact_tables = router_config.compact_tables;
+    routing_settings.router_fixed_point_tables =
+        router_config.fixed_point_tables;
+    routing_settings.graph_model = router_config.graph_model;
+    auto bm = BusManager::Create(config, routing_settings);
+    ASSERT_TRUE(bm);
+
+    EXPECT_FALSE(bm->Update({PostBusRequest{
+        .bus = "bus0", .stops = {"stop0", "missing", "stop0"}}}))
+              << "Unknown stop";
+    EXPECT_FALSE(bm->Update({random_bus("bus0"), random_bus("bus0")}))
+              << "Two requests of a bus";
+
+    for (auto &[name, update] : updates) {
+      ASSERT_TRUE(bm->Update(update)) << name;
+      auto want = BusManager::Create(bm->GetRequests(), routing_settings);
+      ASSERT_TRUE(want) << name;
+
+      for (int i = 0; i <= bus_count; ++i) {
+        const string bus = "bus" + to_string(i);
+        EXPECT_EQ(want->GetBusInfo(bus), bm->GetBusInfo(bus)) << name;
+      }
+      for (int from = 0; from <= stop_count; ++from) {
+        auto want_info = want->GetStopInfo(stop_name(from));
+        auto got_info = bm->GetStopInfo(stop_name(from));
+        ASSERT_EQ(want_info.has_value(), got_info.has_value()) << name;
+        if (got_info) {
+          EXPECT_EQ(want_info->buses, got_info->buses) << name;
+        }
+        for (int to = 0; to <= stop_count; ++to) {
+          auto want_route = want->GetRoute(stop_name(from), stop_name(to));
+          auto got_route = bm->GetRoute(stop_name(from), stop_name(to));
+          ASSERT_EQ(want_route.has_value(), got_route.has_value()) << name;
+          if (!got_route) continue;
+          EXPECT_TRUE(CompareLength(want_route->time, got_route->time, 9))
+                    << name;
+          ExpectConsistentRoute(*got_route, name);
+        }
+      }
+    }
+  }
+  // The buses of a cache written for other request order come in other order.
+  const string cache_path = testing::TempDir() + "bus_manager_update.bin";
+  auto reordered = config;
+  reverse(reordered.begin(), reordered.end());
+  for (auto graph_model : {GraphModel::kPairwise, GraphModel::kTransit}) {
+    filesystem::remove(cache_path);
+    auto routing_settings = kTestRoutingSettings;
+    routing_settings.graph_model = graph_model;
+    routing_settings.router_cache_path = cache_path;
+    ASSERT_TRUE(BusManager::Create(config, routing_settings));
+    auto bm = BusManager::Create(reordered, routing_settings);
+    ASSERT_TRUE(bm);
+    ASSERT_TRUE(bm->Update({shorter}));
+
+    routing_settings.router_cache_path.clear();
+    auto want = BusManager::Create(bm->GetRequests(), routing_settings);
+    ASSERT_TRUE(want);
+    for (int from = 0; from < stop_count; ++from) {
+      for (int to = 0; to < stop_count; ++to) {
+        auto want_route = want->GetRoute(stop_name(from), stop_name(to));
+        auto got_route = bm->GetRoute(stop_name(from), stop_name(to));
+        ASSERT_EQ(want_route.has_value(), got_route.has_value());
+        if (!got_route) continue;
+        EXPECT_TRUE(CompareLength(want_route->time, got_route->time, 9))
+                  << "Cache";
+      }
+    }
+  }
+  filesystem::remove(cache_path);
+
 }
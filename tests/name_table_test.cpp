@@ -0,0 +1,45 @@
+#include "src/name_table.h"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace std;
+
+TEST(TestNameTable, TestIntern) {
+  rm::NameTable table;
+  EXPECT_EQ(0, table.GetSize());
+  EXPECT_EQ(nullopt, table.Find("stop"));
+
+  EXPECT_EQ(0, table.Intern("stop"));
+  EXPECT_EQ(1, table.Intern("other stop"));
+  EXPECT_EQ(0, table.Intern(string("stop"))) << "Interned once";
+  EXPECT_EQ(2, table.Intern(""));
+  EXPECT_EQ(3, table.GetSize());
+
+  EXPECT_EQ(optional<rm::NameId>(1), table.Find("other stop"));
+  EXPECT_EQ(optional<rm::NameId>(2), table.Find(""));
+  EXPECT_EQ(nullopt, table.Find("other"));
+  EXPECT_EQ("stop", table.GetName(0));
+  EXPECT_EQ("other stop", table.GetName(1));
+}
+
+TEST(TestNameTable, TestStableNames) {
+  rm::NameTable table;
+  const string &first = table.GetName(table.Intern("stop0"));
+
+  // The keys of the index view the names, so they must not move.
+  vector<rm::NameId> ids;
+  for (int i = 1; i < 1000; ++i) {
+    ids.push_back(table.Intern("stop" + to_string(i)));
+  }
+  EXPECT_EQ("stop0", first);
+  EXPECT_EQ(&first, &table.GetName(0));
+  for (int i = 1; i < 1000; ++i) {
+    EXPECT_EQ(optional<rm::NameId>(ids[i - 1]),
+              table.Find("stop" + to_string(i)));
+    EXPECT_EQ("stop" + to_string(i), table.GetName(ids[i - 1]));
+  }
+}
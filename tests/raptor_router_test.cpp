@@ -0,0 +1,172 @@
+#include "src/raptor_router.h"
+
+#include <optional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/base_reader.h"
+#include "src/common.h"
+#include "src/request_types.h"
+#include "src/route_manager.h"
+#include "test_utils.h"
+
+using namespace std;
+
+namespace {
+struct Network {
+  vector<string> stops;
+  unordered_map<string, vector<string>> routes;
+  rm::Base base;
+};
+
+Network RandomNetwork(int stop_count, int bus_count, unsigned seed) {
+  mt19937 gen(seed);
+  uniform_int_distribution<int> stop(0, stop_count - 1);
+  uniform_int_distribution<int> route_size(2, 8);
+  uniform_int_distribution<int> distance(100, 5000);
+  uniform_real_distribution<double> coord(0.0, 0.5);
+
+  Network network;
+  vector<rm::PostStopRequest> stop_requests(stop_count);
+  for (int i = 0; i < stop_count; ++i) {
+    network.stops.push_back("stop" + to_string(i));
+    stop_requests[i] = {.stop = network.stops[i],
+                        .coords = {coord(gen), coord(gen)}};
+  }
+  vector<rm::PostRequest> requests;
+  for (int i = 0; i < bus_count; ++i) {
+    vector<int> route;
+    for (size_t size = route_size(gen); route.size() < size;) {
+      route.push_back(stop(gen));
+    }
+    for (size_t idx = 1; idx < route.size(); ++idx) {
+      // Some segments fall back to the geo distance.
+      if (gen() % 4 == 0) continue;
+      stop_requests[route[idx - 1]].stop_distances[network.stops[route[idx]]] =
+          distance(gen);
+    }
+    auto &bus = get<rm::PostBusRequest>(
+        requests.emplace_back(rm::PostBusRequest{.bus = "bus" + to_string(i)}));
+    for (auto idx : route) {
+      bus.stops.push_back(network.stops[idx]);
+    }
+    network.routes[bus.bus] = bus.stops;
+  }
+  requests.insert(requests.end(), stop_requests.begin(), stop_requests.end());
+  network.base = rm::ReadBase(requests);
+  return network;
+}
+
+// Checks that the rides follow the bus routes from `from` to `to`.
+void ExpectValidRoute(const Network &network,
+                      const rm::RouteInfo &route,
+                      const string &from,
+                      const string &to) {
+  string stop = from;
+  for (auto &item : route.items) {
+    if (auto wait = get_if<rm::RouteInfo::WaitItem>(&item)) {
+      EXPECT_EQ(stop, wait->stop);
+    } else {
+      auto &ride = get<rm::RouteInfo::RoadItem>(item);
+      auto &bus_stops = network.routes.at(ride.bus);
+      ASSERT_GT(ride.span_count, 0);
+      ASSERT_LT(ride.start_idx + ride.span_count, bus_stops.size());
+      EXPECT_EQ(stop, bus_stops[ride.start_idx]);
+      stop = bus_stops[ride.start_idx + ride.span_count];
+    }
+  }
+  EXPECT_EQ(to, stop);
+}
+}
+
+TEST(TestRaptorRouter, TestFindRoute) {
+  using WaitItem = rm::RouteInfo::WaitItem;
+  using RoadItem = rm::RouteInfo::RoadItem;
+
+  const auto base = rm::ReadBase({
+      rm::PostStopRequest{.stop = "A", .stop_distances = {{"B", 1000}}},
+      rm::PostStopRequest{.stop = "B",
+          .stop_distances = {{"C", 1000}, {"D", 6000}}},
+      rm::PostStopRequest{.stop = "C", .stop_distances = {{"D", 1000}}},
+      rm::PostStopRequest{.stop = "D"},
+      rm::PostStopRequest{.stop = "E"},
+      rm::PostBusRequest{.bus = "slow", .stops = {"A", "B", "D"}},
+      rm::PostBusRequest{.bus = "fast", .stops = {"B", "C", "D"}},
+  });
+  const rm::RaptorRouter router(base, rm::RoutingSettings{
+      .bus_wait_time = 2, .bus_velocity = 60});
+
+  struct TestCase {
+    string name;
+    string from;
+    string to;
+    optional<rm::RouteInfo> want;
+  };
+
+  vector<TestCase> test_cases{
+      TestCase{
+          .name = "Same stop",
+          .from = "A", .to = "A",
+          .want = rm::RouteInfo{.time = 0, .items = {}},
+      },
+      TestCase{
+          .name = "Transfer beats the direct bus",
+          .from = "A", .to = "D",
+          .want = rm::RouteInfo{.time = 7, .items = {
+              WaitItem{.stop = "A", .time = 2},
+              RoadItem{.bus = "slow", .time = 1, .start_idx = 0,
+                  .span_count = 1},
+              WaitItem{.stop = "B", .time = 2},
+              RoadItem{.bus = "fast", .time = 2, .start_idx = 0,
+                  .span_count = 2},
+          }},
+      },
+      TestCase{
+          .name = "Unreachable stop",
+          .from = "A", .to = "E",
+          .want = nullopt,
+      },
+      TestCase{
+          .name = "Against the route direction",
+          .from = "D", .to = "A",
+          .want = nullopt,
+      },
+      TestCase{
+          .name = "Unknown stop",
+          .from = "A", .to = "F",
+          .want = nullopt,
+      },
+  };
+
+  for (auto &[name, from, to, want] : test_cases) {
+    EXPECT_EQ(want, router.FindRoute(from, to)) << name;
+  }
+}
+
+TEST(TestRaptorRouter, TestRandomNetworks) {
+  const rm::RoutingSettings settings{.bus_wait_time = 5, .bus_velocity = 30};
+  for (unsigned seed = 0; seed < 5; ++seed) {
+    const auto network = RandomNetwork(30, 12, seed);
+    rm::RouteManager floyd_warshall(network.base, settings);
+    const rm::RaptorRouter raptor(network.base, settings);
+
+    for (auto &from : network.stops) {
+      for (auto &to : network.stops) {
+        auto want = floyd_warshall.FindRoute(from, to);
+        auto got = raptor.FindRoute(from, to);
+        ASSERT_EQ(want.has_value(), got.has_value()) << from << ' ' << to;
+        if (!want) continue;
+
+        EXPECT_TRUE(rm::CompareLength(want->time, got->time, 9))
+                  << from << ' ' << to << ": " << want->time << " vs "
+                  << got->time;
+        ExpectValidRoute(network, *got, from, to);
+      }
+    }
+  }
+}
@@ -591,6 +591,71 @@ TEST(TestOutputRequest, TestGetRouteRequest) {
   }
 }
 
+TEST(TestOutputRequest, TestGetRouteMatrixRequest) {
+  using namespace rm;
+  struct TestCase {
+    std::string name;
+    json::Dict input;
+    std::optional<GetRouteMatrixRequest> want;
+  };
+
+  std::vector<TestCase> test_cases{
+      TestCase{
+          .name = "Wrong request: no <targets>",
+          .input = json::Dict{{"type", "RouteMatrix"},
+                              {"id", 1},
+                              {"sources", json::List{"stop 1"}}},
+          .want = std::nullopt,
+      },
+      TestCase{
+          .name = "<sources> isn't a list of strings",
+          .input = json::Dict{{"type", "RouteMatrix"},
+                              {"id", 1},
+                              {"sources", json::List{"stop 1", 2}},
+                              {"targets", json::List{"stop 2"}}},
+          .want = std::nullopt,
+      },
+      TestCase{
+          .name = "<with_items> isn't bool",
+          .input = json::Dict{{"type", "RouteMatrix"},
+                              {"id", 1},
+                              {"sources", json::List{"stop 1"}},
+                              {"targets", json::List{"stop 2"}},
+                              {"with_items", 1}},
+          .want = std::nullopt,
+      },
+      TestCase{
+          .name = "Times only",
+          .input = json::Dict{{"type", "RouteMatrix"},
+                              {"id", 2},
+                              {"sources", json::List{"stop 1"}},
+                              {"targets", json::List{"stop 2", "stop 3"}}},
+          .want = GetRouteMatrixRequest{
+              .id = 2,
+              .sources = {"stop 1"},
+              .targets = {"stop 2", "stop 3"}},
+      },
+      TestCase{
+          .name = "With items",
+          .input = json::Dict{{"type", "RouteMatrix"},
+                              {"id", 3},
+                              {"sources", json::List{"stop 1", "stop 2"}},
+                              {"targets", json::List{}},
+                              {"with_items", true}},
+          .want = GetRouteMatrixRequest{
+              .id = 3,
+              .sources = {"stop 1", "stop 2"},
+              .targets = {},
+              .with_items = true},
+      },
+  };
+
+  for (auto &[name, input, want] : test_cases) {
+    auto got = ParseGetRouteMatrixRequest(input);
+    EXPECT_EQ(want, got) << name;
+  }
+}
+
 TEST(TestOutputRequest, TestGetStopRequest) {
   using namespace rm;
 
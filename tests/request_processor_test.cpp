@@ -208,3 +208,57 @@ TEST(TestProcessRequests, TestMapResponseToJson) {
   json::Dict got = rm::ToJson(rm::MapResponse{.map = "My map"}, 12);
   EXPECT_EQ(want, got);
 }
+
+TEST(TestProcessRequests, TestRouteMatrixResponseToJson) {
+  struct TestCase {
+    std::string name;
+    rm::RouteMatrixResponse response;
+    int id;
+    json::Dict want;
+  };
+
+  std::vector<TestCase> test_cases{
+      TestCase{
+          .name = "Times only",
+          .response = rm::RouteMatrixResponse{
+              .times = {{0.0, 12.5}, {std::nullopt, 3.0}}},
+          .id = 7,
+          .want = json::Dict{
+              {"request_id", 7},
+              {"times", json::List{json::List{0.0, 12.5},
+                                   json::List{json::Node(), 3.0}}}},
+      },
+      TestCase{
+          .name = "With items",
+          .response = rm::RouteMatrixResponse{
+              .times = {{7.5, std::nullopt}},
+              .routes = {{
+                  rm::RouteResponse{
+                      .time = 7.5,
+                      .items = {
+                          rm::RouteResponse::WaitItem{.stop = "A", .time = 5},
+                          rm::RouteResponse::RoadItem{
+                              .bus = "1", .time = 2.5, .span_count = 2}}},
+                  std::nullopt}}},
+          .id = 8,
+          .want = json::Dict{
+              {"request_id", 8},
+              {"times", json::List{json::List{7.5, json::Node()}}},
+              {"items", json::List{json::List{
+                  json::List{
+                      json::Dict{{"time", 5},
+                                 {"type", "Wait"},
+                                 {"stop_name", "A"}},
+                      json::Dict{{"time", 2.5},
+                                 {"bus", "1"},
+                                 {"type", "Bus"},
+                                 {"span_count", 2}}},
+                  json::Node()}}}},
+      },
+  };
+
+  for (auto &[name, response, id, want] : test_cases) {
+    json::Dict got = rm::ToJson(response, id);
+    EXPECT_EQ(want, got) << name;
+  }
+}
@@ -0,0 +1,205 @@
+#include "src/router_cache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/base_reader.h"
+#include "src/common.h"
+#include "src/request_types.h"
+#include "src/route_manager.h"
+#include "test_utils.h"
+
+using namespace std;
+
+namespace {
+// Stops A, B, C, D and buses 1, 2, in this order.
+vector<rm::PostRequest> TestRequests() {
+  return {
+      rm::PostStopRequest{.stop = "A", .coords = {55.61, 37.20},
+          .stop_distances = {{"B", 3000}}},
+      rm::PostStopRequest{.stop = "B", .coords = {55.59, 37.21},
+          .stop_distances = {{"C", 4000}, {"A", 2500}}},
+      rm::PostStopRequest{.stop = "C", .coords = {55.58, 37.23},
+          .stop_distances = {{"B", 3500}, {"D", 1000}}},
+      rm::PostStopRequest{.stop = "D", .coords = {55.57, 37.24},
+          .stop_distances = {{"C", 1200}}},
+      rm::PostBusRequest{.bus = "1", .stops = {"A", "B", "C", "B", "A"}},
+      rm::PostBusRequest{.bus = "2", .stops = {"B", "C", "D", "C", "B"}},
+  };
+}
+
+rm::PostStopRequest &GetStop(vector<rm::PostRequest> &requests, int idx) {
+  return get<rm::PostStopRequest>(requests[idx]);
+}
+
+rm::PostBusRequest &GetBus(vector<rm::PostRequest> &requests, int idx) {
+  return get<rm::PostBusRequest>(requests[4 + idx]);
+}
+
+vector<optional<rm::RouteInfo>> FindAllRoutes(rm::RouteManager &manager) {
+  vector<optional<rm::RouteInfo>> routes;
+  for (auto from : {"A", "B", "C", "D"}) {
+    for (auto to : {"A", "B", "C", "D"}) {
+      routes.push_back(manager.FindRoute(from, to));
+    }
+  }
+  return routes;
+}
+}
+
+TEST(TestRouterCache, TestReadWrite) {
+  stringstream ss;
+  rm::CacheWriter writer(ss);
+  WriteCacheHeader(writer, 42);
+  writer.Write<int>(-7);
+  writer.WriteString("stop");
+  const vector<double> array = {1.5, 2.5, 3.5};
+  writer.WriteArray(array.data(), array.size());
+
+  // Arrays are aligned relative to the start of the file, like in a mapping.
+  alignas(rm::kArrayAlignment) char data[256];
+  const string str = ss.str();
+  ASSERT_LE(str.size(), sizeof(data));
+  copy(str.begin(), str.end(), data);
+
+  {
+    rm::CacheReader reader(data, str.size());
+    int value;
+    string stop;
+    ASSERT_TRUE(ReadCacheHeader(reader, 42));
+    ASSERT_TRUE(reader.Read(value));
+    ASSERT_TRUE(reader.ReadString(stop));
+    auto got = reader.ReadArray<double>(array.size());
+    ASSERT_NE(nullptr, got);
+    EXPECT_EQ(-7, value);
+    EXPECT_EQ("stop", stop);
+    EXPECT_EQ(array, vector<double>(got, got + array.size()));
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(got) % rm::kArrayAlignment);
+    EXPECT_TRUE(reader.AtEnd());
+  }
+  {
+    rm::CacheReader reader(data, str.size());
+    EXPECT_FALSE(ReadCacheHeader(reader, 43)) << "Other key";
+  }
+  {
+    rm::CacheReader reader(data, str.size() - 1);
+    int value;
+    string stop;
+    ASSERT_TRUE(ReadCacheHeader(reader, 42));
+    ASSERT_TRUE(reader.Read(value));
+    ASSERT_TRUE(reader.ReadString(stop));
+    EXPECT_EQ(nullptr, reader.ReadArray<double>(array.size())) << "Truncated";
+  }
+}
+
+TEST(TestRouterCache, TestCacheKey) {
+  const rm::RoutingSettings settings{.bus_wait_time = 6, .bus_velocity = 40};
+  const auto base = rm::ReadBase(TestRequests());
+  const auto key = rm::ComputeRouterCacheKey(base, settings);
+
+  auto reordered = TestRequests();
+  reverse(reordered.begin(), reordered.end());
+  EXPECT_EQ(key, rm::ComputeRouterCacheKey(rm::ReadBase(reordered), settings))
+            << "Other ids";
+
+  auto requests = TestRequests();
+  GetStop(requests, 0).stop_distances["B"] = 3001;
+  EXPECT_NE(key, rm::ComputeRouterCacheKey(rm::ReadBase(requests), settings));
+
+  requests = TestRequests();
+  GetBus(requests, 1).stops.pop_back();
+  EXPECT_NE(key, rm::ComputeRouterCacheKey(rm::ReadBase(requests), settings));
+
+  auto other_settings = settings;
+  other_settings.bus_wait_time = 7;
+  EXPECT_NE(key, rm::ComputeRouterCacheKey(base, other_settings));
+  other_settings = settings;
+  other_settings.router_compact_tables = true;
+  EXPECT_NE(key, rm::ComputeRouterCacheKey(base, other_settings));
+  other_settings = settings;
+  other_settings.router_fixed_point_tables = true;
+  EXPECT_NE(key, rm::ComputeRouterCacheKey(base, other_settings));
+  other_settings = settings;
+  other_settings.graph_model = rm::GraphModel::kTransit;
+  EXPECT_NE(key, rm::ComputeRouterCacheKey(base, other_settings));
+  other_settings = settings;
+  other_settings.router_threads = 4;
+  EXPECT_EQ(key, rm::ComputeRouterCacheKey(base, other_settings))
+            << "The tables don't depend on the thread count";
+}
+
+TEST(TestRouterCache, TestRouteManager) {
+  const string path = testing::TempDir() + "router_cache_test.bin";
+  filesystem::remove(path);
+
+  for (auto [compact_tables, fixed_point_tables, graph_model] : {
+      tuple{false, false, rm::GraphModel::kPairwise},
+      tuple{true, false, rm::GraphModel::kPairwise},
+      tuple{false, true, rm::GraphModel::kPairwise},
+      tuple{false, false, rm::GraphModel::kTransit}}) {
+    const rm::RoutingSettings settings{
+        .bus_wait_time = 6, .bus_velocity = 40,
+        .router_compact_tables = compact_tables,
+        .router_fixed_point_tables = fixed_point_tables,
+        .router_cache_path = path, .graph_model = graph_model};
+    const auto base = rm::ReadBase(TestRequests());
+
+    rm::RouteManager built(base, settings);
+    const auto want = FindAllRoutes(built);
+    ASSERT_TRUE(filesystem::exists(path));
+    const auto file_size = filesystem::file_size(path);
+
+    rm::RouteManager loaded(base, settings);
+    EXPECT_EQ(want, FindAllRoutes(loaded)) << "Loaded";
+
+    // The cache refers to the stops and buses by name.
+    auto reordered = TestRequests();
+    reverse(reordered.begin(), reordered.end());
+    rm::RouteManager loaded_reordered(rm::ReadBase(reordered), settings);
+    EXPECT_EQ(want, FindAllRoutes(loaded_reordered)) << "Other ids";
+
+    // The route edges come last in the file.
+    auto read_tail = [&] {
+      ifstream file(path, ios::binary);
+      file.seekg(-4, ios::end);
+      string tail(4, '\0');
+      file.read(tail.data(), 4);
+      return tail;
+    };
+    const string tail = read_tail();
+    {
+      fstream file(path, ios::in | ios::out | ios::binary);
+      file.seekp(-4, ios::end);
+      file.write("\x7f\x7f\x7f\x7f", 4);
+    }
+    rm::RouteManager damaged(base, settings);
+    EXPECT_EQ(want, FindAllRoutes(damaged)) << "Damaged file";
+    EXPECT_EQ(tail, read_tail()) << "Rewritten damaged file";
+
+    filesystem::resize_file(path, file_size / 2);
+    rm::RouteManager rebuilt(base, settings);
+    EXPECT_EQ(want, FindAllRoutes(rebuilt)) << "Truncated file";
+    EXPECT_EQ(file_size, filesystem::file_size(path)) << "Rewritten";
+
+    auto requests = TestRequests();
+    GetStop(requests, 2).stop_distances["D"] = 900;
+    const auto other_base = rm::ReadBase(requests);
+    rm::RouteManager changed(other_base, settings);
+    rm::RouteManager uncached(other_base, rm::RoutingSettings{
+        .bus_wait_time = 6, .bus_velocity = 40,
+        .router_compact_tables = compact_tables,
+        .router_fixed_point_tables = fixed_point_tables,
+        .graph_model = graph_model});
+    EXPECT_EQ(FindAllRoutes(uncached), FindAllRoutes(changed)) << "New input";
+  }
+  filesystem::remove(path);
+}
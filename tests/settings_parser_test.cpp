@@ -49,6 +49,194 @@ TEST(TestParseSettings, TestRoutingSettings) {
                               {"bus_wait_time", 10}},
           .want = RoutingSettings{.bus_wait_time = 10, .bus_velocity = 10.1}
       },
+      TestCase{
+          .name = "Wrong request: <router> isn't string",
+          .input = json::Dict{{"bus_velocity", 10.1},
+                              {"bus_wait_time", 10},
+                              {"router", 1}},
+          .want = std::nullopt
+      },
+      TestCase{
+          .name = "Wrong request: unknown <router>",
+          .input = json::Dict{{"bus_velocity", 10.1},
+                              {"bus_wait_time", 10},
+                              {"router", "bellman_ford"}},
+          .want = std::nullopt
+      },
+      TestCase{
+          .name = "Floyd-Warshall router",
+          .input = json::Dict{{"bus_velocity", 10.1},
+                              {"bus_wait_time", 10},
+                              {"router", "floyd_warshall"}},
+          .want = RoutingSettings{.bus_wait_time = 10, .bus_velocity = 10.1,
+              .router_type = RouterType::kFloydWarshall}
+      },
+      TestCase{
+          .name = "Dijkstra router",
+          .input = json::Dict{{"bus_velocity", 10.1},
+                              {"bus_wait_time", 10},
+                              {"router", "dijkstra"}},
+          .want = RoutingSettings{.bus_wait_time = 10, .bus_velocity = 10.1,
+              .router_type = RouterType::kDijkstra}
+      },
+      TestCase{
+          .name = "RAPTOR router",
+          .input = json::Dict{{"bus_velocity", 10.1},
+                              {"bus_wait_time", 10},
+                              {"router", "raptor"}},
+          .want = RoutingSettings{.bus_wait_time = 10, .bus_velocity = 10.1,
+              .router_type = RouterType::kRaptor}
+      },
+      TestCase{
+          .name = "Contraction hierarchy router",
+          .input = json::Dict{{"bus_velocity", 10.1},
+                              {"bus_wait_time", 10},
+                              {"router", "contraction_hierarchy"}},
+          .want = RoutingSettings{.bus_wait_time = 10, .bus_velocity = 10.1,
+              .router_type = RouterType::kContractionHierarchy}
+      },
+      TestCase{
+          .name = "A* router",
+          .input = json::Dict{{"bus_velocity", 10.1},
+                              {"bus_wait_time", 10},
+                              {"router", "a_star"}},
+          .want = RoutingSettings{.bus_wait_time = 10, .bus_velocity = 10.1,
+              .router_type = RouterType::kAStar}
+      },
+      TestCase{
+          .name = "Bidirectional Dijkstra router",
+          .input = json::Dict{{"bus_velocity", 10.1},
+                              {"bus_wait_time", 10},
+                              {"router", "bidirectional_dijkstra"}},
+          .want = RoutingSettings{.bus_wait_time = 10, .bus_velocity = 10.1,
+              .router_type = RouterType::kBidirectionalDijkstra}
+      },
+      TestCase{
+          .name = "Hub label router",
+          .input = json::Dict{{"bus_velocity", 10.1},
+                              {"bus_wait_time", 10},
+                              {"router", "hub_labels"}},
+          .want = RoutingSettings{.bus_wait_time = 10, .bus_velocity = 10.1,
+              .router_type = RouterType::kHubLabels}
+      },
+      TestCase{
+          .name = "Tree cache router",
+          .input = json::Dict{{"bus_velocity", 10.1},
+                              {"bus_wait_time", 10},
+                              {"router", "tree_cache"},
+                              {"router_tree_cache_size", 8}},
+          .want = RoutingSettings{.bus_wait_time = 10, .bus_velocity = 10.1,
+              .router_type = RouterType::kTreeCache,
+              .router_tree_cache_size = 8}
+      },
+      TestCase{
+          .name = "Overlay router",
+          .input = json::Dict{{"bus_velocity", 10.1},
+                              {"bus_wait_time", 10},
+                              {"router", "overlay"},
+                              {"router_threads", 2}},
+          .want = RoutingSettings{.bus_wait_time = 10, .bus_velocity = 10.1,
+              .router_type = RouterType::kOverlay,
+              .router_threads = 2}
+      },
+      TestCase{
+          .name = "Wrong request: <router_tree_cache_size> isn't positive",
+          .input = json::Dict{{"bus_velocity", 10.1},
+                              {"bus_wait_time", 10},
+                              {"router_tree_cache_size", 0}},
+          .want = std::nullopt
+      },
+      TestCase{
+          .name = "Wrong request: <router_threads> isn't int",
+          .input = json::Dict{{"bus_velocity", 10.1},
+                              {"bus_wait_time", 10},
+                              {"router_threads", 2.5}},
+          .want = std::nullopt
+      },
+      TestCase{
+          .name = "Wrong request: <router_threads> isn't positive",
+          .input = json::Dict{{"bus_velocity", 10.1},
+                              {"bus_wait_time", 10},
+                              {"router_threads", 0}},
+          .want = std::nullopt
+      },
+      TestCase{
+          .name = "Parallel precomputation",
+          .input = json::Dict{{"bus_velocity", 10.1},
+                              {"bus_wait_time", 10},
+                              {"router_threads", 8}},
+          .want = RoutingSettings{.bus_wait_time = 10, .bus_velocity = 10.1,
+              .router_threads = 8}
+      },
+      TestCase{
+          .name = "Wrong request: <router_compact_tables> isn't bool",
+          .input = json::Dict{{"bus_velocity", 10.1},
+                              {"bus_wait_time", 10},
+                              {"router_compact_tables", 1}},
+          .want = std::nullopt
+      },
+      TestCase{
+          .name = "Compact tables",
+          .input = json::Dict{{"bus_velocity", 10.1},
+                              {"bus_wait_time", 10},
+                              {"router_compact_tables", true}},
+          .want = RoutingSettings{.bus_wait_time = 10, .bus_velocity = 10.1,
+              .router_compact_tables = true}
+      },
+      TestCase{
+          .name = "Fixed-point tables",
+          .input = json::Dict{{"bus_velocity", 10.1},
+                              {"bus_wait_time", 10},
+                              {"router_fixed_point_tables", true}},
+          .want = RoutingSettings{.bus_wait_time = 10, .bus_velocity = 10.1,
+              .router_fixed_point_tables = true}
+      },
+      TestCase{
+          .name = "Wrong request: both compact and fixed-point tables",
+          .input = json::Dict{{"bus_velocity", 10.1},
+                              {"bus_wait_time", 10},
+                              {"router_compact_tables", true},
+                              {"router_fixed_point_tables", true}},
+          .want = std::nullopt
+      },
+      TestCase{
+          .name = "Wrong request: <router_cache_path> isn't string",
+          .input = json::Dict{{"bus_velocity", 10.1},
+                              {"bus_wait_time", 10},
+                              {"router_cache_path", true}},
+          .want = std::nullopt
+      },
+      TestCase{
+          .name = "Router cache",
+          .input = json::Dict{{"bus_velocity", 10.1},
+                              {"bus_wait_time", 10},
+                              {"router_cache_path", "routes.bin"}},
+          .want = RoutingSettings{.bus_wait_time = 10, .bus_velocity = 10.1,
+              .router_cache_path = "routes.bin"}
+      },
+      TestCase{
+          .name = "Wrong request: unknown <graph_model>",
+          .input = json::Dict{{"bus_velocity", 10.1},
+                              {"bus_wait_time", 10},
+                              {"graph_model", "complete"}},
+          .want = std::nullopt
+      },
+      TestCase{
+          .name = "Pairwise graph model",
+          .input = json::Dict{{"bus_velocity", 10.1},
+                              {"bus_wait_time", 10},
+                              {"graph_model", "pairwise"}},
+          .want = RoutingSettings{.bus_wait_time = 10, .bus_velocity = 10.1,
+              .graph_model = GraphModel::kPairwise}
+      },
+      TestCase{
+          .name = "Transit graph model",
+          .input = json::Dict{{"bus_velocity", 10.1},
+                              {"bus_wait_time", 10},
+                              {"graph_model", "transit"}},
+          .want = RoutingSettings{.bus_wait_time = 10, .bus_velocity = 10.1,
+              .graph_model = GraphModel::kTransit}
+      },
   };
 
   for (auto &[name, input, want] : test_cases) {
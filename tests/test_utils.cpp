@@ -38,6 +38,12 @@ bool operator==(const GetMapRequest &lhs, const GetMapRequest &rhs) {
   return lhs.id == rhs.id;
 }
 
+bool operator==(const GetRouteMatrixRequest &lhs,
+                const GetRouteMatrixRequest &rhs) {
+  return tie(lhs.id, lhs.sources, lhs.targets, lhs.with_items) ==
+      tie(rhs.id, rhs.sources, rhs.targets, rhs.with_items);
+}
+
 bool operator==(const BusResponse &lhs, const BusResponse &rhs) {
   return tie(lhs.stop_count, lhs.unique_stop_count, lhs.length)
       == tie(rhs.stop_count, rhs.unique_stop_count, rhs.length);
@@ -60,8 +66,16 @@ bool operator==(const PostStopRequest &lhs, const PostStopRequest &rhs) {
 }
 
 bool operator==(const RoutingSettings &lhs, const RoutingSettings &rhs) {
-  return tie(lhs.bus_wait_time, lhs.bus_velocity)
-      == tie(rhs.bus_wait_time, rhs.bus_velocity);
+  return tie(lhs.bus_wait_time, lhs.bus_velocity, lhs.router_type,
+             lhs.router_threads, lhs.router_compact_tables,
+             lhs.router_fixed_point_tables,
+             lhs.router_tree_cache_size, lhs.router_cache_path,
+             lhs.graph_model)
+      == tie(rhs.bus_wait_time, rhs.bus_velocity, rhs.router_type,
+             rhs.router_threads, rhs.router_compact_tables,
+             rhs.router_fixed_point_tables,
+             rhs.router_tree_cache_size, rhs.router_cache_path,
+             rhs.graph_model);
 }
 
 bool operator==(const RenderingSettings &lhs, const RenderingSettings &rhs) {
@@ -130,6 +144,11 @@ bool operator!=(const GetMapRequest &lhs, const GetMapRequest &rhs) {
   return !(lhs == rhs);
 }
 
+bool operator!=(const GetRouteMatrixRequest &lhs,
+                const GetRouteMatrixRequest &rhs) {
+  return !(lhs == rhs);
+}
+
 bool operator!=(const BusResponse &lhs, const BusResponse &rhs) {
   return !(lhs == rhs);
 }
@@ -195,13 +214,28 @@ ostream &operator<<(ostream &out, const GetMapRequest &mr) {
   return out << mr.id;
 }
 
+ostream &operator<<(ostream &out, const GetRouteMatrixRequest &mr) {
+  out << mr.id << ":";
+  for (auto &stop : mr.sources) out << ' ' << stop;
+  out << " ->";
+  for (auto &stop : mr.targets) out << ' ' << stop;
+  return out << (mr.with_items ? " with items" : "");
+}
+
 ostream &operator<<(ostream &out, const BusResponse &br) {
   return out << br.stop_count << ' ' << br.unique_stop_count << ' '
              << br.length;
 }
 
 ostream &operator<<(ostream &out, const RoutingSettings &settings) {
-  return out << settings.bus_wait_time << ' ' << settings.bus_velocity;
+  return out << settings.bus_wait_time << ' ' << settings.bus_velocity << ' '
+             << static_cast<int>(settings.router_type) << ' '
+             << settings.router_threads << ' '
+             << settings.router_compact_tables << ' '
+             << settings.router_fixed_point_tables << ' '
+             << settings.router_tree_cache_size << ' '
+             << settings.router_cache_path << ' '
+             << static_cast<int>(settings.graph_model);
 }
 
 ostream &operator<<(ostream &out, const Frame &frame) {
@@ -36,6 +36,12 @@ bool operator==(const GetMapRequest &lhs, const GetMapRequest &rhs);
 
 bool operator!=(const GetMapRequest &lhs, const GetMapRequest &rhs);
 
+bool operator==(const GetRouteMatrixRequest &lhs,
+                const GetRouteMatrixRequest &rhs);
+
+bool operator!=(const GetRouteMatrixRequest &lhs,
+                const GetRouteMatrixRequest &rhs);
+
 bool operator==(const PostBusRequest &lhs, const PostBusRequest &rhs);
 
 bool operator!=(const PostBusRequest &lhs, const PostBusRequest &rhs);
@@ -88,6 +94,8 @@ std::ostream &operator<<(std::ostream &out, const GetBusRequest &br);
 
 std::ostream &operator<<(std::ostream &out, const GetMapRequest &br);
 
+std::ostream &operator<<(std::ostream &out, const GetRouteMatrixRequest &mr);
+
 std::ostream &operator<<(std::ostream &out, const BusResponse &br);
 
 std::ostream &operator<<(std::ostream &out, const RoutingSettings &settings);